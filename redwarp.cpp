@@ -0,0 +1,1165 @@
+#include "redwarp.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <filesystem>
+#include <vector>
+#include <random>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <cstdlib>
+#include <mutex>
+#include <cmath>
+#include <cctype>
+#include <limits>
+
+// Cross-platform process / filesystem
+#ifdef _WIN32
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#  include <io.h>       // _chmod
+#  include <sys/stat.h> // _S_IEXEC
+#else
+#  include <unistd.h>
+#  include <fcntl.h>
+#  include <cerrno>
+#  include <sys/wait.h>
+#  include <sys/stat.h>
+#endif
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// ---------------------------------------------------------------------------
+// Platform detection helpers
+// ---------------------------------------------------------------------------
+#ifdef _WIN32
+#  define PLATFORM_WINDOWS 1
+#  define EXE_EXT ".exe"
+#else
+#  define PLATFORM_WINDOWS 0
+#  define EXE_EXT ""
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+#  define ARCH_STR "amd64"
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#  define ARCH_STR "arm64"
+#elif defined(__arm__) || defined(_M_ARM)
+#  define ARCH_STR "armv7"
+#else
+#  define ARCH_STR "386"
+#endif
+
+#if PLATFORM_WINDOWS
+#  define OS_STR "windows"
+#elif defined(__APPLE__)
+#  define OS_STR "darwin"
+#else
+#  define OS_STR "linux"
+#endif
+
+namespace redwarp {
+
+// ---------------------------------------------------------------------------
+// Random helpers – one engine per thread, so no locking is needed
+// ---------------------------------------------------------------------------
+static mt19937& rng() {
+    thread_local mt19937 gen{random_device{}()};
+    return gen;
+}
+
+static int random_int(int lo, int hi) {
+    uniform_int_distribution<int> d(lo, hi);
+    return d(rng());
+}
+
+static uint32_t random_uint32(uint32_t lo = 1u, uint32_t hi = 0xFFFFFFFFu) {
+    uniform_int_distribution<uint32_t> d(lo, hi);
+    return d(rng());
+}
+
+static vector<uint8_t> rand_bytes(size_t n) {
+    uniform_int_distribution<unsigned> d(0, 255);
+    vector<uint8_t> out(n);
+    for (auto& b : out) b = static_cast<uint8_t>(d(rng()));
+    return out;
+}
+
+static string to_hex(const vector<uint8_t>& bytes) {
+    ostringstream ss;
+    ss << hex << setfill('0');
+    for (uint8_t b : bytes) ss << setw(2) << (unsigned)b;
+    return ss.str();
+}
+
+static string rand_hex(size_t n)  { return to_hex(rand_bytes(n)); }
+
+static string rand_ip() {
+    return to_string(random_int(10,239)) + "." +
+           to_string(random_int(1,254))  + "." +
+           to_string(random_int(1,254))  + "." +
+           to_string(random_int(1,254));
+}
+
+static int rand_port() { return random_int(1024, 65534); }
+
+template<typename T>
+static const T& pick(const vector<T>& v) { return v[random_int(0,(int)v.size()-1)]; }
+
+// ---------------------------------------------------------------------------
+// run_command – shell-free on both platforms
+// Windows: CreateProcess   Linux/macOS: fork+execv
+// cwd:    working directory for the child ("" = inherit ours)
+// output: when non-null, receives the child's stdout and stderr
+// ---------------------------------------------------------------------------
+static bool run_command(const string& exe, const vector<string>& args,
+                        const string& cwd = "", string* output = nullptr) {
+#if PLATFORM_WINDOWS
+    // Build a properly-quoted command line for CreateProcess
+    // Each token is wrapped in double-quotes; internal quotes are escaped.
+    auto quote_arg = [](const string& s) -> string {
+        string out = "\"";
+        for (char c : s) {
+            if (c == '"') out += "\\\"";
+            else          out += c;
+        }
+        out += '"';
+        return out;
+    };
+
+    string cmdline = quote_arg(exe);
+    for (const auto& a : args) cmdline += " " + quote_arg(a);
+
+    STARTUPINFOA si{};
+    si.cb = sizeof(si);
+    PROCESS_INFORMATION pi{};
+
+    // The write end is inheritable until our child has it and we closed our
+    // copy; a process started by another thread in that window would inherit
+    // it too and keep ReadFile() below blocked until it exits.
+    static mutex spawn_mutex;
+    unique_lock<mutex> spawn_lock(spawn_mutex, defer_lock);
+
+    HANDLE read_end = nullptr, write_end = nullptr;
+    if (output) {
+        spawn_lock.lock();
+        SECURITY_ATTRIBUTES sa{sizeof(sa), nullptr, TRUE};
+        if (!CreatePipe(&read_end, &write_end, &sa, 0)) return false;
+        SetHandleInformation(read_end, HANDLE_FLAG_INHERIT, 0);
+        si.dwFlags    = STARTF_USESTDHANDLES;
+        si.hStdInput  = GetStdHandle(STD_INPUT_HANDLE);
+        si.hStdOutput = write_end;
+        si.hStdError  = write_end;
+    }
+
+    BOOL started = CreateProcessA(
+            nullptr,
+            cmdline.data(),   // mutable copy
+            nullptr, nullptr,
+            output ? TRUE : FALSE,
+            CREATE_NO_WINDOW,
+            nullptr,
+            cwd.empty() ? nullptr : cwd.c_str(),
+            &si, &pi);
+
+    if (output) {
+        CloseHandle(write_end);
+        spawn_lock.unlock();
+        if (started) {
+            char buf[4096];
+            DWORD n = 0;
+            while (ReadFile(read_end, buf, sizeof(buf), &n, nullptr) && n > 0)
+                output->append(buf, n);
+        }
+        CloseHandle(read_end);
+    }
+    if (!started) return false;
+
+    WaitForSingleObject(pi.hProcess, INFINITE);
+    DWORD exit_code = 1;
+    GetExitCodeProcess(pi.hProcess, &exit_code);
+    CloseHandle(pi.hProcess);
+    CloseHandle(pi.hThread);
+    return exit_code == 0;
+
+#else
+    // Everything the child needs is allocated before fork(): other threads
+    // may hold the allocator lock at the moment we fork.
+    vector<const char*> argv;
+    argv.push_back(exe.c_str());
+    for (const auto& a : args) argv.push_back(a.c_str());
+    argv.push_back(nullptr);
+
+    // The pipe must be close-on-exec from the start, or a child forked by
+    // another thread in between inherits the write end and read() below
+    // blocks until that unrelated child exits.
+    int fds[2] = {-1, -1};
+#ifdef __linux__
+    if (output && pipe2(fds, O_CLOEXEC) != 0) return false;
+    pid_t pid = fork();
+#else
+    // No pipe2(): serialize pipe+fcntl+fork against our own other forks
+    static mutex fork_mutex;
+    pid_t pid;
+    {
+        lock_guard<mutex> lock(fork_mutex);
+        if (output) {
+            if (pipe(fds) != 0) return false;
+            fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+            fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+        }
+        pid = fork();
+    }
+#endif
+    if (pid < 0) {
+        if (output) { close(fds[0]); close(fds[1]); }
+        return false;
+    }
+
+    if (pid == 0) {
+        if (output) {
+            dup2(fds[1], STDOUT_FILENO);
+            dup2(fds[1], STDERR_FILENO);
+        }
+        if (!cwd.empty() && chdir(cwd.c_str()) != 0) _exit(127);
+        execv(exe.c_str(), const_cast<char* const*>(argv.data()));
+        _exit(127);
+    }
+
+    if (output) {
+        close(fds[1]);
+        char buf[4096];
+        ssize_t n;
+        while ((n = read(fds[0], buf, sizeof(buf))) != 0) {
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            output->append(buf, size_t(n));
+        }
+        close(fds[0]);
+    }
+
+    int status = 0;
+    if (waitpid(pid, &status, 0) < 0) return false;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// find_curl – returns full path to curl or empty string
+// ---------------------------------------------------------------------------
+static string find_curl() {
+#if PLATFORM_WINDOWS
+    // Try PATH via where.exe, fall back to common locations
+    static const vector<string> CANDIDATES = {
+        "C:\\Windows\\System32\\curl.exe",
+        "C:\\Program Files\\Git\\mingw64\\bin\\curl.exe",
+        "C:\\ProgramData\\chocolatey\\bin\\curl.exe"
+    };
+    for (const auto& p : CANDIDATES)
+        if (error_code ec; fs::exists(p, ec)) return p;
+    // Last resort: rely on PATH (may work on Win10 1803+)
+    return "curl.exe";
+#else
+    static const vector<string> CANDIDATES = {
+        "/usr/bin/curl",
+        "/usr/local/bin/curl",
+        "/opt/homebrew/bin/curl"  // macOS Homebrew arm64
+    };
+    for (const auto& p : CANDIDATES)
+        if (error_code ec; fs::exists(p, ec)) return p;
+    return "curl";  // hope it's in PATH
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// make_executable – chmod +x (no-op on Windows; Explorer handles .exe)
+// ---------------------------------------------------------------------------
+static void make_executable(const string& path) {
+#if PLATFORM_WINDOWS
+    // Windows executability is determined by extension – nothing to do
+    (void)path;
+#else
+    struct stat st{};
+    if (stat(path.c_str(), &st) == 0)
+        chmod(path.c_str(), st.st_mode | S_IXUSR | S_IXGRP | S_IXOTH);
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// download_latest_wgcf (ported from F# downloadLatestWgcf)
+// ---------------------------------------------------------------------------
+static string download_latest_wgcf(const string& bin_dir) {
+    const string curl     = find_curl();
+    const string os_name  = OS_STR;
+    const string arch     = ARCH_STR;
+    const string filename = string("wgcf_") + os_name + "_" + arch + EXE_EXT;
+    const string target   = bin_dir + "/" + filename;
+    const string json_tmp = bin_dir + "/wgcf_release.json";
+
+    const string api_url =
+        "https://api.github.com/repos/ViRb3/wgcf/releases/latest";
+
+    if (!run_command(curl,
+            {"-fsSL", "-A", "RedWARP-Generator", "-o", json_tmp, api_url})) {
+        return {};
+    }
+
+    ifstream jf(json_tmp);
+    string json((istreambuf_iterator<char>(jf)),
+                 istreambuf_iterator<char>());
+    jf.close();
+    error_code ec;
+    fs::remove(json_tmp, ec);
+
+    // Find browser_download_url matching our os+arch
+    string download_url;
+    size_t pos = 0;
+    while ((pos = json.find("browser_download_url", pos)) != string::npos) {
+        size_t s = json.find('"', pos + 22);
+        if (s == string::npos) break;
+        size_t e = json.find('"', s + 1);
+        if (e == string::npos) break;
+        string url = json.substr(s + 1, e - s - 1);
+        if (url.find(os_name) != string::npos &&
+            url.find(arch)    != string::npos) {
+            download_url = url;
+            break;
+        }
+        pos = e;
+    }
+
+    if (download_url.empty()) return {};
+
+    if (!run_command(curl,
+            {"-fsSL", "-A", "RedWARP-Generator", "-o", target, download_url}))
+        return {};
+
+    make_executable(target);
+    return target;
+}
+
+// ---------------------------------------------------------------------------
+// ensure_wgcf_exists (ported from F# ensureWgcfExists)
+// Serialized so concurrent callers never race on the same download.
+// ---------------------------------------------------------------------------
+string ensure_wgcf_exists(const string& bin_dir) {
+    static mutex m;
+    lock_guard<mutex> lock(m);
+
+    error_code ec;
+    fs::create_directories(bin_dir, ec);
+
+    for (fs::directory_iterator it(bin_dir, ec), end; !ec && it != end;
+         it.increment(ec)) {
+        const string name = it->path().filename().string();
+        if (name.rfind("wgcf", 0) == 0) {
+            make_executable(it->path().string());
+            return it->path().string();
+        }
+    }
+
+    return download_latest_wgcf(bin_dir);
+}
+
+// ---------------------------------------------------------------------------
+// Junk-packet generators (ported from F# Program.fs)
+//   I1 = SIP REGISTER   I2 = TLS ClientHello  I3 = TLS ServerHello
+//   I4 = TLS AppData    I5 = HTTP GET
+// ---------------------------------------------------------------------------
+
+static const vector<string> POPULAR_DOMAINS = {
+    "google.com","youtube.com","cloudflare.com","apple.com","microsoft.com",
+    "facebook.com","instagram.com","whatsapp.com","wikipedia.org","amazon.com",
+    "bing.com","reddit.com","chatgpt.com","netflix.com","tiktok.com",
+    "akamai.com","fastly.com","yandex.ru","vk.com","mail.ru",
+    "dzen.ru","ozon.ru","wildberries.ru","avito.ru","gosuslugi.ru",
+    "sber.ru","vkontakte.ru","ok.ru","rambler.ru","ria.ru",
+    "baidu.com","qq.com","taobao.com","weibo.com","163.com",
+    "alibaba.com","tmall.com","jd.com","douyin.com","sina.com.cn",
+    "tencent.com","pinduoduo.com","ximalaya.com","yahoo.com","linkedin.com",
+    "twitch.tv","spotify.com","adobe.com","ebay.com","paypal.com",
+    "booking.com","airbnb.com","aliexpress.com","huawei.com","samsung.com",
+    "sony.com","nvidia.com","intel.com","oracle.com","ibm.com",
+    "zoom.us","discord.com","telegram.org","github.com","stackoverflow.com",
+    "medium.com","quora.com","bbc.com","cnn.com","nytimes.com",
+    "washingtonpost.com","naver.com","daum.net","line.me"
+};
+
+static string wrap_packet(const vector<uint8_t>& data) {
+    return "<b 0x" + to_hex(data) + ">";
+}
+
+// I1: SIP REGISTER
+static string make_sip_register() {
+    auto ip      = rand_ip();
+    int  srcPort = rand_port();
+    auto branch  = rand_hex(26);
+    auto callId  = rand_hex(16);
+    auto fromTag = rand_hex(8);
+    auto domain  = pick(POPULAR_DOMAINS);
+    int  expires = random_int(3600, 7200);
+    int  cseq    = random_int(1, 9);
+
+    ostringstream body;
+    body << "REGISTER sip:" << domain << " SIP/2.0\r\n"
+         << "Via: SIP/2.0/UDP " << ip << ":" << srcPort
+             << ";branch=z9hG4bK" << branch << "\r\n"
+         << "Max-Forwards: 70\r\n"
+         << "To: <sip:user@" << domain << ">\r\n"
+         << "From: <sip:user@" << domain << ">;tag=" << fromTag << "\r\n"
+         << "Call-ID: " << callId << "\r\n"
+         << "CSeq: " << cseq << " REGISTER\r\n"
+         << "Contact: <sip:user@" << ip << ":" << srcPort << ">\r\n"
+         << "User-Agent: Bria 5.0.0\r\n"
+         << "Expires: " << expires << "\r\n"
+         << "Content-Length: 0\r\n\r\n";
+
+    string s = body.str();
+    return wrap_packet(vector<uint8_t>(s.begin(), s.end()));
+}
+
+// I2: TLS ClientHello
+static string make_tls_client_hello() {
+    auto sni      = pick(POPULAR_DOMAINS);
+    auto sniBytes = vector<uint8_t>(sni.begin(), sni.end());
+    size_t sniLen = sniBytes.size();
+    auto clientRandom = rand_bytes(32);
+
+    static const vector<uint16_t> ALL_CIPHERS = {
+        0xC02B,0xC02C,0xCCA8,0xCCA9,0xC013,0xC014,0x009C,0x009D
+    };
+    int numCiphers = random_int(2, 4);
+    vector<uint16_t> ciphers(numCiphers);
+    for (auto& c : ciphers) c = pick(ALL_CIPHERS);
+
+    vector<uint8_t> sniExt = {
+        0x00, 0x00,
+        0x00, uint8_t(sniLen + 5),
+        0x00, uint8_t(sniLen + 3),
+        0x00,
+        0x00, uint8_t(sniLen)
+    };
+    sniExt.insert(sniExt.end(), sniBytes.begin(), sniBytes.end());
+
+    vector<uint8_t> sgExt = {0x00,0x0A,0x00,0x0A,0x00,0x08,
+                              0x7B,0x88,0x65,0x2C,0xE4,0x6B,0x47,0xAB};
+    vector<uint8_t> epExt = {0x00,0x0B,0x00,0x04,0x03,0x00,0x01,0x02};
+
+    vector<uint8_t> exts;
+    for (auto& e : {sniExt, sgExt, epExt})
+        exts.insert(exts.end(), e.begin(), e.end());
+
+    vector<uint8_t> cipherBytes;
+    for (auto c : ciphers) {
+        cipherBytes.push_back(uint8_t(c >> 8));
+        cipherBytes.push_back(uint8_t(c));
+    }
+
+    vector<uint8_t> helloBody;
+    helloBody.insert(helloBody.end(), clientRandom.begin(), clientRandom.end());
+    helloBody.push_back(0x00);
+    helloBody.push_back(0x00);
+    helloBody.push_back(uint8_t(cipherBytes.size()));
+    helloBody.insert(helloBody.end(), cipherBytes.begin(), cipherBytes.end());
+    helloBody.push_back(0x01); helloBody.push_back(0x00);
+    helloBody.push_back(0x00); helloBody.push_back(uint8_t(exts.size()));
+    helloBody.insert(helloBody.end(), exts.begin(), exts.end());
+
+    uint16_t helloLen = uint16_t(helloBody.size());
+    vector<uint8_t> handshake = {
+        0x01, 0x00, 0x00, uint8_t(helloLen), 0x03, 0x03
+    };
+    handshake.insert(handshake.end(), helloBody.begin(), helloBody.end());
+
+    uint16_t hsLen = uint16_t(handshake.size());
+    vector<uint8_t> record = {
+        0x16, 0x03, 0x03, uint8_t(hsLen >> 8), uint8_t(hsLen)
+    };
+    record.insert(record.end(), handshake.begin(), handshake.end());
+    return wrap_packet(record);
+}
+
+// I3: TLS ServerHello
+static string make_tls_server_hello() {
+    auto serverRandom = rand_bytes(32);
+    static const vector<uint16_t> CIPHERS = {
+        0xC02F,0xC030,0xCCA8,0x009C,0x009D,0xC013,0xC014
+    };
+    uint16_t cipher = pick(CIPHERS);
+
+    vector<uint8_t> handshake = {
+        0x02, 0x00, 0x00, uint8_t(serverRandom.size() + 4),
+        0x03, 0x03
+    };
+    handshake.insert(handshake.end(), serverRandom.begin(), serverRandom.end());
+    handshake.push_back(0x00);
+    handshake.push_back(uint8_t(cipher >> 8));
+    handshake.push_back(uint8_t(cipher));
+    handshake.push_back(0x00);
+
+    uint16_t hsLen = uint16_t(handshake.size());
+    vector<uint8_t> record = {
+        0x16, 0x03, 0x03, uint8_t(hsLen >> 8), uint8_t(hsLen)
+    };
+    record.insert(record.end(), handshake.begin(), handshake.end());
+    return wrap_packet(record);
+}
+
+// I4: TLS AppData – DHE KeyExchange + ChangeCipherSpec + Finished
+static string make_tls_appdata() {
+    auto dhPart = rand_bytes(128);
+    vector<uint8_t> keyExBody = {0x10, 0x00, 0x00, 0x80};
+    keyExBody.insert(keyExBody.end(), dhPart.begin(), dhPart.end());
+
+    vector<uint8_t> keyExRec = {
+        0x16, 0x03, 0x03, 0x00, uint8_t(keyExBody.size())
+    };
+    keyExRec.insert(keyExRec.end(), keyExBody.begin(), keyExBody.end());
+
+    vector<uint8_t> ccsRec = {0x14, 0x03, 0x03, 0x00, 0x01, 0x01};
+
+    auto finData = rand_bytes(52);
+    vector<uint8_t> finRec = {
+        0x16, 0x03, 0x03, 0x00, uint8_t(finData.size())
+    };
+    finRec.insert(finRec.end(), finData.begin(), finData.end());
+
+    vector<uint8_t> full;
+    for (auto& part : {keyExRec, ccsRec, finRec})
+        full.insert(full.end(), part.begin(), part.end());
+
+    return wrap_packet(full);
+}
+
+// I5: HTTP GET
+static string make_http_get() {
+    static const vector<string> PATHS = {
+        "/mail","/search","/index.html","/api/v1/status","/favicon.ico","/"
+    };
+    static const vector<string> UAS = {
+        "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/146.0.0.0 Safari/537.36",
+        "Mozilla/5.0 (Macintosh; Intel Mac OS X 10_15_7) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/146.0.0.0 Safari/537.36",
+        "Mozilla/5.0 (Windows NT 10.0; Win64; x64; rv:149.0) Gecko/20100101 Firefox/149.0",
+        "Mozilla/5.0 (iPhone; CPU iPhone OS 18_7_7 like Mac OS X) AppleWebKit/605.1.15 (KHTML, like Gecko) Version/26.0 Mobile/15E148 Safari/604.1",
+        "Mozilla/5.0 (Linux; Android 15; SM-S931B) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/146.0.7680.178 Mobile Safari/537.36",
+        "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/146.0.0.0 Safari/537.36 Edg/146.0.0.0",
+        "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/146.0.0.0 Safari/537.36"
+    };
+
+    string host = pick(POPULAR_DOMAINS);
+    string path = pick(PATHS);
+    string ua   = pick(UAS);
+
+    ostringstream body;
+    body << "GET " << path << " HTTP/1.1\r\n"
+         << "Host: " << host << "\r\n"
+         << "User-Agent: " << ua << "\r\n"
+         << "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/webp,*/*;q=0.8\r\n"
+         << "Accept-Language: en-US,en;q=0.5\r\n"
+         << "Accept-Encoding: gzip, deflate, br\r\n"
+         << "Connection: keep-alive\r\n\r\n";
+
+    string s = body.str();
+    return wrap_packet(vector<uint8_t>(s.begin(), s.end()));
+}
+
+namespace {
+struct JunkPackets { string i1, i2, i3, i4, i5; };
+}
+
+static JunkPackets generate_junk_packets() {
+    return {
+        make_sip_register(),
+        make_tls_client_hello(),
+        make_tls_server_hello(),
+        make_tls_appdata(),
+        make_http_get()
+    };
+}
+// ---------------------------------------------------------------------------
+// Endpoint pool
+//   Round-robin: entry = seq % entries, then ports change fastest, hosts next
+//   Weighted:    random entry proportional to @weight, random host and port
+//   Hash:        weighted rendezvous hash of profile_name over the entries,
+//                so adding or removing an entry only moves its own share
+// ---------------------------------------------------------------------------
+namespace {
+struct PoolEntry {
+    string           key;        // entry text, stable input for hashing
+    string           host;       // literal host, or "" when CIDR is used
+    uint32_t         base  = 0;  // first usable address of the CIDR
+    uint64_t         hosts = 1;
+    vector<uint16_t> ports;
+    double           weight = 1.0;
+};
+}
+
+static uint64_t fnv1a(const string& s, uint64_t h = 1469598103934665603ull) {
+    for (unsigned char c : s) { h ^= c; h *= 1099511628211ull; }
+    return h;
+}
+
+// splitmix64 finalizer – spreads a hash over all 64 bits
+static uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+static bool parse_uint(const string& s, uint64_t max, uint64_t& out) {
+    if (s.empty() || s.size() > 10) return false;
+    out = 0;
+    for (char c : s) {
+        if (c < '0' || c > '9') return false;
+        out = out * 10 + uint64_t(c - '0');
+    }
+    return out <= max;
+}
+
+static bool parse_ipv4(const string& s, uint32_t& out) {
+    out = 0;
+    size_t start = 0;
+    for (int i = 0; i < 4; ++i) {
+        size_t end = (i < 3) ? s.find('.', start) : s.size();
+        if (end == string::npos) return false;
+        uint64_t octet;
+        if (!parse_uint(s.substr(start, end - start), 255, octet)) return false;
+        out = (out << 8) | uint32_t(octet);
+        start = end + 1;
+    }
+    return true;
+}
+
+static string format_ipv4(uint32_t a) {
+    return to_string(a >> 24) + "." + to_string((a >> 16) & 255) + "." +
+           to_string((a >> 8) & 255) + "." + to_string(a & 255);
+}
+
+static bool parse_ports(const string& s, vector<uint16_t>& out) {
+    size_t start = 0;
+    while (start <= s.size()) {
+        size_t end = s.find(',', start);
+        if (end == string::npos) end = s.size();
+        string item = s.substr(start, end - start);
+        size_t dash = item.find('-');
+        uint64_t lo, hi;
+        if (dash == string::npos) {
+            if (!parse_uint(item, 65535, lo) || lo == 0) return false;
+            hi = lo;
+        } else if (!parse_uint(item.substr(0, dash), 65535, lo) ||
+                   !parse_uint(item.substr(dash + 1), 65535, hi) ||
+                   lo == 0 || hi < lo) {
+            return false;
+        }
+        for (uint64_t p = lo; p <= hi; ++p) out.push_back(uint16_t(p));
+        start = end + 1;
+    }
+    return !out.empty();
+}
+
+static bool parse_pool_entry(const string& text, PoolEntry& e, string& error) {
+    e.key = text;
+    string rest = text;
+
+    size_t at = rest.rfind('@');
+    if (at != string::npos) {
+        uint64_t w;
+        if (!parse_uint(rest.substr(at + 1), 1000000, w) || w == 0) {
+            error = "bad weight in \"" + text + "\"";
+            return false;
+        }
+        e.weight = double(w);
+        rest.erase(at);
+    }
+
+    string host, ports;
+    if (!rest.empty() && rest[0] == '[') {
+        size_t close = rest.find(']');
+        if (close == string::npos) {
+            error = "unterminated IPv6 address in \"" + text + "\"";
+            return false;
+        }
+        host = rest.substr(0, close + 1);
+        if (close + 1 < rest.size()) {
+            if (rest[close + 1] != ':') {
+                error = "expected ':' after IPv6 address in \"" + text + "\"";
+                return false;
+            }
+            ports = rest.substr(close + 2);
+        }
+    } else {
+        size_t colon = rest.find(':');
+        host  = rest.substr(0, colon);
+        if (colon != string::npos) ports = rest.substr(colon + 1);
+    }
+
+    if (host.empty()) {
+        error = "missing host in \"" + text + "\"";
+        return false;
+    }
+    if (ports.empty()) e.ports.push_back(2408);
+    else if (!parse_ports(ports, e.ports)) {
+        error = "bad port list in \"" + text + "\"";
+        return false;
+    }
+
+    size_t slash = host.find('/');
+    if (slash == string::npos) {
+        e.host = host;
+        return true;
+    }
+
+    uint32_t addr;
+    uint64_t len;
+    if (!parse_ipv4(host.substr(0, slash), addr) ||
+        !parse_uint(host.substr(slash + 1), 32, len)) {
+        error = "bad IPv4 prefix in \"" + text + "\"";
+        return false;
+    }
+    uint32_t mask = len == 0 ? 0 : ~uint32_t(0) << (32 - len);
+    e.base  = addr & mask;
+    e.hosts = uint64_t(1) << (32 - len);
+    if (len <= 30) {          // skip network and broadcast addresses
+        e.base  += 1;
+        e.hosts -= 2;
+    }
+    return true;
+}
+
+static bool parse_pool(const string& spec, vector<PoolEntry>& pool, string& error) {
+    string token;
+    auto flush = [&]() -> bool {
+        if (token.empty()) return true;
+        PoolEntry e;
+        if (!parse_pool_entry(token, e, error)) return false;
+        pool.push_back(std::move(e));
+        token.clear();
+        return true;
+    };
+    for (char c : spec) {
+        if (c == ';' || isspace(static_cast<unsigned char>(c))) {
+            if (!flush()) return false;
+        } else {
+            token += c;
+        }
+    }
+    if (!flush()) return false;
+    if (pool.empty()) error = "endpoint pool is empty";
+    return !pool.empty();
+}
+
+static string endpoint_at(const PoolEntry& e, uint64_t host_idx, uint64_t port_idx) {
+    string host = e.host.empty() ? format_ipv4(e.base + uint32_t(host_idx % e.hosts))
+                                 : e.host;
+    return host + ":" + to_string(e.ports[port_idx % e.ports.size()]);
+}
+
+string pick_endpoint(const Options& opts, string* error) {
+    vector<PoolEntry> pool;
+    string err;
+    if (!parse_pool(opts.endpoint, pool, err)) {
+        if (error) *error = "Invalid endpoint pool: " + err;
+        return {};
+    }
+
+    switch (opts.endpoint_strategy) {
+    case EndpointStrategy::Weighted: {
+        vector<double> weights;
+        for (const auto& e : pool) weights.push_back(e.weight);
+        discrete_distribution<size_t> d(weights.begin(), weights.end());
+        const PoolEntry& e = pool[d(rng())];
+        uniform_int_distribution<uint64_t> h(0, e.hosts - 1);
+        uniform_int_distribution<uint64_t> p(0, e.ports.size() - 1);
+        return endpoint_at(e, h(rng()), p(rng()));
+    }
+    case EndpointStrategy::Hash: {
+        const uint64_t name_hash = fnv1a(opts.profile_name);
+        size_t best = 0;
+        double best_score = -numeric_limits<double>::infinity();
+        for (size_t i = 0; i < pool.size(); ++i) {
+            // u in (0,1); score = -w / ln(u) gives weight-proportional shares
+            uint64_t h = mix64(fnv1a(pool[i].key, name_hash));
+            double u = (double(h >> 11) + 0.5) / double(uint64_t(1) << 53);
+            double score = -pool[i].weight / log(u);
+            if (score > best_score) { best_score = score; best = i; }
+        }
+        return endpoint_at(pool[best], mix64(name_hash ^ 1), mix64(name_hash ^ 2));
+    }
+    case EndpointStrategy::RoundRobin:
+    default: {
+        const PoolEntry& e = pool[opts.sequence % pool.size()];
+        uint64_t inner = opts.sequence / pool.size();
+        return endpoint_at(e, inner / e.ports.size(), inner);
+    }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// apply_options – rewrite a raw wgcf profile according to opts
+// ---------------------------------------------------------------------------
+string apply_options(const string& profile, const Options& opts) {
+    istringstream infile(profile);
+    ostringstream outfile;
+
+    auto junk = generate_junk_packets();
+
+    string line;
+    bool interface_section = false;
+
+    while (getline(infile, line)) {
+        if (line.find("[Interface]") == 0)
+            interface_section = true;
+        else if (!line.empty() && line[0] == '[')
+            interface_section = false;
+
+        if (!opts.ipv6) {
+            size_t pos;
+            if (line.find("Address = ") == 0) {
+                pos = line.find(',');
+                if (pos != string::npos) line = line.substr(0, pos);
+            }
+            while ((pos = line.find(", ::/0")) != string::npos) line.erase(pos, 6);
+            while ((pos = line.find(",::/0"))  != string::npos) line.erase(pos, 5);
+            while ((pos = line.find(", 2606:4700")) != string::npos) line.erase(pos, 50);
+        }
+
+        if (interface_section && line.find("PrivateKey =") == 0 && opts.amnezia) {
+            outfile << line << "\n";
+
+            const bool rnd = opts.randomize_amnezia;
+            int Jc   = rnd ? random_int(1, 128) : 4;
+            int Jmin = rnd ? random_int(1, 400) : 40;
+            int Jmax = rnd ? random_int(Jmin + 1, 1280) : 70;
+            uint32_t h3 = random_uint32(2073986817u, 2147128181u);
+
+            outfile << "S1 = 0\n"
+                    << "S2 = 0\n"
+                    << "Jc = "   << Jc   << "\n"
+                    << "Jmin = " << Jmin << "\n"
+                    << "Jmax = " << Jmax << "\n";
+
+            if (rnd) {
+                outfile << "H1 = " << (random_uint32() % 4 + 1) << "\n"
+                        << "H2 = " << (random_uint32() % 4 + 1) << "\n"
+                        << "H3 = " << h3                         << "\n"
+                        << "H4 = " << (random_uint32() % 4 + 1) << "\n";
+            } else {
+                outfile << "H1 = 1\nH2 = 2\nH3 = " << h3 << "\nH4 = 4\n";
+            }
+
+            outfile << "I1 = " << junk.i1 << "\n"
+                    << "I2 = " << junk.i2 << "\n"
+                    << "I3 = " << junk.i3 << "\n"
+                    << "I4 = " << junk.i4 << "\n"
+                    << "I5 = " << junk.i5 << "\n";
+
+        } else if (line.find("MTU = ") == 0) {
+            outfile << "MTU = " << opts.mtu << "\n";
+        } else if (line.find("Endpoint = ") == 0) {
+            outfile << "Endpoint = " << opts.endpoint << "\n";
+        } else if (line.find("DNS = ") == 0) {
+            outfile << "DNS = " << opts.dns_ipv4;
+            if (opts.ipv6)
+                outfile << ", " << opts.dns_ipv6;
+            outfile << "\n";
+        } else {
+            outfile << line << "\n";
+        }
+    }
+
+    return outfile.str();
+}
+
+// ---------------------------------------------------------------------------
+// make_work_dir – private scratch directory for one wgcf run
+// ---------------------------------------------------------------------------
+static string make_work_dir() {
+    error_code ec;
+    const fs::path base = fs::temp_directory_path(ec);
+    if (ec) return {};
+    for (int attempt = 0; attempt < 16; ++attempt) {
+        fs::path dir = base / ("redwarp-" + rand_hex(8));
+        if (fs::create_directory(dir, ec)) return dir.string();
+    }
+    return {};
+}
+
+// Removes the scratch directory on every exit path of generate()
+namespace {
+struct WorkDirGuard {
+    string path;
+    ~WorkDirGuard() {
+        error_code ec;
+        if (!path.empty()) fs::remove_all(path, ec);
+    }
+};
+}
+
+// wgcf reports API errors as text; HTTP 429 is the only one worth pacing for
+static bool looks_rate_limited(string out) {
+    for (auto& c : out) c = char(tolower(static_cast<unsigned char>(c)));
+    if (out.find("too many requests") != string::npos ||
+        out.find("rate limit") != string::npos)
+        return true;
+
+    // A status code stands alone – not part of an ID, hex string or number
+    auto word_char = [](char c) { return isalnum(static_cast<unsigned char>(c)) != 0; };
+    for (size_t pos = out.find("429"); pos != string::npos; pos = out.find("429", pos + 1)) {
+        const bool starts = pos == 0 || !word_char(out[pos - 1]);
+        const bool ends   = pos + 3 == out.size() || !word_char(out[pos + 3]);
+        if (starts && ends) return true;
+    }
+    return false;
+}
+
+// "what failed" plus the last non-empty line wgcf printed, if any
+static string command_error(const string& what, const string& output) {
+    size_t end = output.find_last_not_of(" \t\r\n");
+    if (end == string::npos) return what;
+    size_t start = output.find_last_of('\n', end);
+    start = (start == string::npos) ? 0 : start + 1;
+    return what + "\n" + output.substr(start, end - start + 1);
+}
+
+// ---------------------------------------------------------------------------
+// resolve_wgcf – explicit wgcf_path, or the one in bin_dir (downloaded once)
+// ---------------------------------------------------------------------------
+string resolve_wgcf(const Options& opts, string* error) {
+    string wgcf_path = opts.wgcf_path.empty()
+                     ? ensure_wgcf_exists(opts.bin_dir.empty() ? "./bin"
+                                                               : opts.bin_dir)
+                     : opts.wgcf_path;
+    error_code ec;
+    if (wgcf_path.empty() || !fs::exists(wgcf_path, ec)) {
+        if (error)
+            *error = "wgcf binary not found and could not be downloaded.\n"
+                     "Place wgcf" EXE_EXT " in ./bin/ or check your internet connection.";
+        return {};
+    }
+    // The child runs inside the account dir, so relative paths would break
+    fs::path absolute = fs::absolute(wgcf_path, ec);
+    if (ec) {
+        if (error) *error = "Cannot resolve " + wgcf_path + ": " + ec.message();
+        return {};
+    }
+    return absolute.string();
+}
+
+// ---------------------------------------------------------------------------
+// register_account – `wgcf register` inside account_dir
+// ---------------------------------------------------------------------------
+RegisterOutcome register_account(const string& wgcf_path, const string& account_dir) {
+    RegisterOutcome out;
+
+    error_code ec;
+    fs::create_directories(account_dir, ec);
+    fs::remove(fs::path(account_dir) / "wgcf-account.toml", ec);
+
+    string output;
+    if (!run_command(wgcf_path, {"register", "--accept-tos"}, account_dir, &output)) {
+        out.status = looks_rate_limited(output) ? RegisterOutcome::RateLimited
+                                                : RegisterOutcome::Failed;
+        out.error  = command_error("Error running: wgcf register --accept-tos", output);
+        return out;
+    }
+    if (!fs::exists(fs::path(account_dir) / "wgcf-account.toml", ec)) {
+        out.error = "wgcf-account.toml not found after register.";
+        return out;
+    }
+
+    out.status = RegisterOutcome::Ok;
+    return out;
+}
+
+// ---------------------------------------------------------------------------
+// finish_profile – pick the endpoint, apply opts and sanity-check the result
+// ---------------------------------------------------------------------------
+Result finish_profile(const string& profile, const Options& opts) {
+    Result res;
+
+    Options resolved = opts;
+    resolved.endpoint = pick_endpoint(opts, &res.error);
+    if (resolved.endpoint.empty()) return res;
+
+    string content = apply_options(profile, resolved);
+
+    if (content.find("MTU = " + resolved.mtu)           == string::npos ||
+        content.find("Endpoint = " + resolved.endpoint) == string::npos ||
+        content.find("DNS = " + resolved.dns_ipv4)      == string::npos) {
+        res.error = "An error occurred while updating the configuration.";
+        return res;
+    }
+
+    res.ok       = true;
+    res.config   = std::move(content);
+    res.endpoint = resolved.endpoint;
+    return res;
+}
+
+// `wgcf generate` in account_dir; the raw profile ends up in res.config
+static Result run_wgcf_generate(const string& wgcf_path, const string& account_dir) {
+    Result res;
+
+    const fs::path profile_path = fs::path(account_dir) / "wgcf-profile.conf";
+    error_code ec;
+    fs::remove(profile_path, ec);
+
+    string output;
+    if (!run_command(wgcf_path, {"generate"}, account_dir, &output)) {
+        res.rate_limited = looks_rate_limited(output);
+        res.error = command_error("Error running: wgcf generate", output);
+        return res;
+    }
+    if (!fs::exists(profile_path, ec)) {
+        res.error = "wgcf-profile.conf not found after generate.";
+        return res;
+    }
+
+    ifstream infile(profile_path);
+    res.config.assign(istreambuf_iterator<char>(infile),
+                      istreambuf_iterator<char>());
+    infile.close();
+    fs::remove(profile_path, ec);
+
+    res.ok = true;
+    return res;
+}
+
+// ---------------------------------------------------------------------------
+// generate_from_account – `wgcf generate` for a registered account + options
+// ---------------------------------------------------------------------------
+Result generate_from_account(const string& wgcf_path, const string& account_dir,
+                             const Options& opts) {
+    // Fail on a bad endpoint pool before spending an API call
+    Result res;
+    if (pick_endpoint(opts, &res.error).empty()) return res;
+
+    res = run_wgcf_generate(wgcf_path, account_dir);
+    if (!res.ok) return res;
+    return finish_profile(res.config, opts);
+}
+
+// ---------------------------------------------------------------------------
+// fetch_profile – fresh account, raw wgcf profile, nothing applied yet
+// ---------------------------------------------------------------------------
+Result fetch_profile(const Options& opts) {
+    Result res;
+
+    const string wgcf_path = resolve_wgcf(opts, &res.error);
+    if (wgcf_path.empty()) return res;
+
+    WorkDirGuard work{make_work_dir()};
+    if (work.path.empty()) {
+        res.error = "Could not create a temporary working directory.";
+        return res;
+    }
+
+    RegisterOutcome reg = register_account(wgcf_path, work.path);
+    if (reg.status != RegisterOutcome::Ok) {
+        res.rate_limited = reg.status == RegisterOutcome::RateLimited;
+        res.error        = reg.error;
+        return res;
+    }
+
+    res = run_wgcf_generate(wgcf_path, work.path);
+    if (res.ok) {
+        // The scratch dir goes away with the guard; hand the account back
+        ifstream account(fs::path(work.path) / "wgcf-account.toml", ios::binary);
+        res.account.assign(istreambuf_iterator<char>(account),
+                           istreambuf_iterator<char>());
+    }
+    return res;
+}
+
+// ---------------------------------------------------------------------------
+// generate – register, generate, apply options; everything stays in memory
+// ---------------------------------------------------------------------------
+Result generate(const Options& opts) {
+    Result res;
+    if (pick_endpoint(opts, &res.error).empty()) return res;
+
+    res = fetch_profile(opts);
+    if (!res.ok) return res;
+
+    string account = std::move(res.account);
+    res = finish_profile(res.config, opts);
+    res.account = std::move(account);
+    return res;
+}
+
+} // namespace redwarp
+
+// ---------------------------------------------------------------------------
+// C ABI
+// ---------------------------------------------------------------------------
+static char* dup_cstr(const string& s) {
+    char* out = static_cast<char*>(malloc(s.size() + 1));
+    if (out) memcpy(out, s.c_str(), s.size() + 1);
+    return out;
+}
+
+extern "C" void redwarp_options_init(redwarp_options* opts) {
+    if (!opts) return;
+    static const redwarp::Options defaults;
+    opts->endpoint          = defaults.endpoint.c_str();
+    opts->endpoint_strategy = int(defaults.endpoint_strategy);
+    opts->profile_name      = defaults.profile_name.c_str();
+    opts->sequence          = defaults.sequence;
+    opts->mtu               = defaults.mtu.c_str();
+    opts->ipv6              = defaults.ipv6;
+    opts->amnezia           = defaults.amnezia;
+    opts->randomize_amnezia = defaults.randomize_amnezia;
+    opts->dns_ipv4          = defaults.dns_ipv4.c_str();
+    opts->dns_ipv6          = defaults.dns_ipv6.c_str();
+    opts->wgcf_path         = nullptr;
+    opts->bin_dir           = nullptr;
+}
+
+extern "C" int redwarp_generate(const redwarp_options* opts, char** config,
+                                char** account, char** error) {
+    if (config)  *config  = nullptr;
+    if (account) *account = nullptr;
+    if (error)   *error   = nullptr;
+
+    try {
+        redwarp::Options o;
+        if (opts) {
+            auto set = [](string& dst, const char* src) { if (src) dst = src; };
+            set(o.endpoint,     opts->endpoint);
+            set(o.profile_name, opts->profile_name);
+            set(o.mtu,          opts->mtu);
+            set(o.dns_ipv4,     opts->dns_ipv4);
+            set(o.dns_ipv6,     opts->dns_ipv6);
+            set(o.wgcf_path,    opts->wgcf_path);
+            if (opts->bin_dir && *opts->bin_dir) o.bin_dir = opts->bin_dir;
+            o.endpoint_strategy =
+                static_cast<redwarp::EndpointStrategy>(opts->endpoint_strategy);
+            o.sequence          = opts->sequence;
+            o.ipv6              = opts->ipv6 != 0;
+            o.amnezia           = opts->amnezia != 0;
+            o.randomize_amnezia = opts->randomize_amnezia != 0;
+        }
+
+        redwarp::Result r = redwarp::generate(o);
+        if (!r.ok) {
+            if (error) *error = dup_cstr(r.error);
+            return -1;
+        }
+        if (config)  *config  = dup_cstr(r.config);
+        if (account) *account = dup_cstr(r.account);
+        return 0;
+    } catch (const exception& e) {
+        if (error) *error = dup_cstr(e.what());
+        return -1;
+    }
+}
+
+extern "C" void redwarp_free(char* str) {
+    free(str);
+}
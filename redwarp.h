@@ -0,0 +1,140 @@
+#ifndef REDWARP_H
+#define REDWARP_H
+
+// ---------------------------------------------------------------------------
+// libredwarp – WARP / AmneziaWG config generation
+//
+// Every call is self-contained: options come in by value, the finished
+// config comes back in memory, and wgcf runs in a private temporary
+// directory.  Concurrent calls from several threads are safe.
+// ---------------------------------------------------------------------------
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ---------------------------------------------------------------------------
+// C ABI
+// ---------------------------------------------------------------------------
+
+// How one endpoint is chosen from an endpoint pool (see Options::endpoint)
+enum {
+    REDWARP_ENDPOINT_ROUND_ROBIN = 0, // walk the pool by sequence number
+    REDWARP_ENDPOINT_WEIGHTED    = 1, // random, proportional to entry weight
+    REDWARP_ENDPOINT_HASH        = 2  // consistent hash of the profile name
+};
+
+typedef struct redwarp_options {
+    const char* endpoint;          // "ip:port" or an endpoint pool
+    int         endpoint_strategy; // REDWARP_ENDPOINT_*
+    const char* profile_name;      // key for REDWARP_ENDPOINT_HASH
+    unsigned long long sequence;   // position in batch for ROUND_ROBIN
+    const char* mtu;
+    int         ipv6;              // non-zero: keep IPv6 addresses / DNS
+    int         amnezia;           // non-zero: add AmneziaWG parameters
+    int         randomize_amnezia; // non-zero: randomize Jc/Jmin/Jmax/H1-H4
+    const char* dns_ipv4;
+    const char* dns_ipv6;
+    const char* wgcf_path;         // NULL/"": search bin_dir, download if missing
+    const char* bin_dir;           // NULL/"": "./bin"
+} redwarp_options;
+
+// Fill *opts with the same defaults the GUI starts with.
+void redwarp_options_init(redwarp_options* opts);
+
+// Returns 0 on success and stores the config in *config and the contents of
+// the new account's wgcf-account.toml in *account (if account != NULL).
+// On failure returns -1 and stores a message in *error (if error != NULL).
+// Strings handed out must be released with redwarp_free().
+int  redwarp_generate(const redwarp_options* opts, char** config, char** account,
+                      char** error);
+void redwarp_free(char* str);
+
+#ifdef __cplusplus
+} // extern "C"
+
+#include <cstdint>
+#include <string>
+
+namespace redwarp {
+
+// ---------------------------------------------------------------------------
+// C++ API
+// ---------------------------------------------------------------------------
+enum class EndpointStrategy {
+    RoundRobin = REDWARP_ENDPOINT_ROUND_ROBIN,
+    Weighted   = REDWARP_ENDPOINT_WEIGHTED,
+    Hash       = REDWARP_ENDPOINT_HASH
+};
+
+struct Options {
+    // Endpoint pool: entries separated by spaces or ';', each entry
+    //   host[:ports][@weight]
+    // host  – IPv4, IPv4 CIDR (162.159.192.0/24), [IPv6] or a hostname
+    // ports – comma list of ports and ranges (500,854,2408-2410), default 2408
+    // A plain "ip:port" is a pool of one.
+    std::string endpoint          = "162.159.192.1:4500";
+    EndpointStrategy endpoint_strategy = EndpointStrategy::RoundRobin;
+    std::string profile_name      = "RedWARP";
+    uint64_t    sequence          = 0;
+    std::string mtu               = "1420";
+    bool        ipv6              = true;
+    bool        amnezia           = true;
+    bool        randomize_amnezia = false;
+    std::string dns_ipv4          = "208.67.222.222, 208.67.220.220";
+    std::string dns_ipv6          = "2620:119:35::35, 2620:119:53::53";
+    std::string wgcf_path;          // empty: search bin_dir, download if missing
+    std::string bin_dir           = "./bin";
+};
+
+struct Result {
+    bool        ok = false;
+    std::string config;   // finished RedWARP.conf contents
+    std::string endpoint; // endpoint picked from the pool
+    std::string error;    // human-readable reason when !ok
+    bool        rate_limited = false; // the API answered 429 – retry later
+    std::string account;  // wgcf-account.toml of a freshly registered account
+};
+
+struct RegisterOutcome {
+    enum Status { Ok, RateLimited, Failed };
+    Status      status = Failed;
+    std::string error;
+};
+
+// Register a fresh account, generate its profile and apply opts.
+Result generate(const Options& opts);
+
+// The stages generate() is built from, for callers that schedule them.
+// resolve_wgcf returns an absolute path to wgcf, or "" and fills *error.
+std::string resolve_wgcf(const Options& opts, std::string* error = nullptr);
+// `wgcf register` inside account_dir (created if missing).
+RegisterOutcome register_account(const std::string& wgcf_path,
+                                 const std::string& account_dir);
+// `wgcf generate` for an account registered in account_dir, then apply opts.
+Result generate_from_account(const std::string& wgcf_path,
+                             const std::string& account_dir,
+                             const Options& opts);
+// Register a fresh account and return its raw wgcf profile in Result::config
+// and its wgcf-account.toml in Result::account.
+// Only the wgcf_path / bin_dir fields of opts are used.
+Result fetch_profile(const Options& opts);
+// Turn a raw profile from fetch_profile() into a finished config.
+Result finish_profile(const std::string& profile, const Options& opts);
+
+// Resolve opts.endpoint to a single "host:port" using opts.endpoint_strategy.
+// Returns "" and fills *error when the pool cannot be parsed.
+std::string pick_endpoint(const Options& opts, std::string* error = nullptr);
+
+// Apply opts to a raw wgcf-profile.conf held in memory.
+// opts.endpoint is written verbatim; resolve pools with pick_endpoint first.
+std::string apply_options(const std::string& profile, const Options& opts);
+
+// Path to a usable wgcf binary in bin_dir (downloaded if needed), or "".
+std::string ensure_wgcf_exists(const std::string& bin_dir);
+
+} // namespace redwarp
+
+#endif // __cplusplus
+
+#endif // REDWARP_H
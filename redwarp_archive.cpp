@@ -0,0 +1,247 @@
+#include "redwarp_archive.h"
+
+#include <cstring>
+#include <ctime>
+
+#ifdef _WIN32
+#  include <io.h>
+#  include <fcntl.h>
+#endif
+
+#ifdef REDWARP_WITH_ZSTD
+#  include <zstd.h>
+#endif
+
+using namespace std;
+
+namespace redwarp {
+
+static const size_t BLOCK = 512;
+
+// ---------------------------------------------------------------------------
+// ustar header – fixed 512-byte block, numbers in zero-padded octal
+// ---------------------------------------------------------------------------
+static void put_octal(char* field, size_t width, uint64_t value) {
+    // width includes the terminating NUL
+    snprintf(field, width, "%0*llo", int(width - 1), (unsigned long long)value);
+}
+
+static void make_header(char* h, const string& name, uint64_t size, time_t mtime) {
+    memset(h, 0, BLOCK);
+    memcpy(h, name.data(), name.size());        // name[100]
+    put_octal(h + 100, 8, 0600);                // mode
+    put_octal(h + 108, 8, 0);                   // uid
+    put_octal(h + 116, 8, 0);                   // gid
+    put_octal(h + 124, 12, size);               // size
+    put_octal(h + 136, 12, uint64_t(mtime));    // mtime
+    h[156] = '0';                               // typeflag: regular file
+    memcpy(h + 257, "ustar", 6);                // magic
+    memcpy(h + 263, "00", 2);                   // version
+
+    // Checksum is computed with its own field set to spaces
+    memset(h + 148, ' ', 8);
+    unsigned sum = 0;
+    for (size_t i = 0; i < BLOCK; ++i) sum += static_cast<unsigned char>(h[i]);
+    snprintf(h + 148, 8, "%06o", sum);
+    h[155] = ' ';
+}
+
+static string json_escape(const string& s) {
+    string out;
+    for (char c : s) {
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n";  break;
+        case '\r': out += "\\r";  break;
+        case '\t': out += "\\t";  break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+    }
+    return out;
+}
+
+// ---------------------------------------------------------------------------
+// ArchiveWriter
+// ---------------------------------------------------------------------------
+ArchiveWriter::~ArchiveWriter() {
+    if (out_) close();
+}
+
+bool ArchiveWriter::zstd_available() {
+#ifdef REDWARP_WITH_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool ArchiveWriter::open(const string& path, int zstd_level, string* error) {
+    lock_guard<mutex> lock(m_);
+    if (out_) {
+        if (error) *error = "Archive is already open.";
+        return false;
+    }
+
+#ifndef REDWARP_WITH_ZSTD
+    if (zstd_level > 0) {
+        if (error) *error = "zstd support is not compiled in (rebuild with make ZSTD=1).";
+        return false;
+    }
+#endif
+
+    if (path == "-") {
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        out_      = stdout;
+        owns_out_ = false;
+    } else {
+        out_ = fopen(path.c_str(), "wb");
+        if (!out_) {
+            if (error) *error = "Could not open " + path + " for writing.";
+            return false;
+        }
+        owns_out_ = true;
+    }
+
+    // Many small members: let stdio batch them into large writes.  stdout
+    // keeps its own buffer – it outlives this writer.
+    if (owns_out_) {
+        file_buf_.resize(1 << 20);
+        setvbuf(out_, file_buf_.data(), _IOFBF, file_buf_.size());
+    }
+
+#ifdef REDWARP_WITH_ZSTD
+    if (zstd_level > 0) {
+        ZSTD_CCtx* cctx = ZSTD_createCCtx();
+        if (!cctx || ZSTD_isError(ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel,
+                                                         zstd_level))) {
+            ZSTD_freeCCtx(cctx);
+            if (owns_out_) fclose(out_);
+            out_ = nullptr;
+            if (error) *error = "Could not set up zstd compression.";
+            return false;
+        }
+        zstd_ = cctx;
+        zstd_buf_.resize(ZSTD_CStreamOutSize());
+    }
+#endif
+
+    failed_ = false;
+    index_.clear();
+    return true;
+}
+
+bool ArchiveWriter::write_locked(const void* data, size_t size) {
+    if (failed_) return false;
+
+#ifdef REDWARP_WITH_ZSTD
+    if (zstd_) {
+        ZSTD_inBuffer in{data, size, 0};
+        while (in.pos < in.size) {
+            ZSTD_outBuffer out{zstd_buf_.data(), zstd_buf_.size(), 0};
+            size_t r = ZSTD_compressStream2(static_cast<ZSTD_CCtx*>(zstd_),
+                                            &out, &in, ZSTD_e_continue);
+            if (ZSTD_isError(r) ||
+                fwrite(zstd_buf_.data(), 1, out.pos, out_) != out.pos) {
+                failed_ = true;
+                return false;
+            }
+        }
+        return true;
+    }
+#endif
+
+    if (fwrite(data, 1, size, out_) != size) failed_ = true;
+    return !failed_;
+}
+
+bool ArchiveWriter::add_member_locked(const string& name, const string& data) {
+    char header[BLOCK];
+    make_header(header, name, data.size(), time(nullptr));
+
+    static const char zeros[BLOCK] = {};
+    const size_t pad = (BLOCK - data.size() % BLOCK) % BLOCK;
+
+    return write_locked(header, BLOCK) &&
+           write_locked(data.data(), data.size()) &&
+           write_locked(zeros, pad);
+}
+
+bool ArchiveWriter::add(const ArchiveEntry& entry, const string& config, string* error) {
+    const string file = entry.name + ".conf";
+    if (file.size() > 100) {
+        if (error) *error = "Profile name too long for the archive: " + entry.name;
+        return false;
+    }
+
+    lock_guard<mutex> lock(m_);
+    if (!out_) {
+        if (error) *error = "Archive is not open.";
+        return false;
+    }
+    if (!add_member_locked(file, config)) {
+        if (error) *error = "Write to archive failed.";
+        return false;
+    }
+
+    index_ += "{\"name\":\""       + json_escape(entry.name)     +
+              "\",\"file\":\""     + json_escape(file)           +
+              "\",\"endpoint\":\"" + json_escape(entry.endpoint) +
+              "\",\"size\":"        + to_string(config.size())    + "}\n";
+    return true;
+}
+
+bool ArchiveWriter::finish_locked() {
+    static const char zeros[2 * BLOCK] = {};
+    if (!add_member_locked("index.jsonl", index_) ||
+        !write_locked(zeros, sizeof(zeros)))
+        return false;
+
+#ifdef REDWARP_WITH_ZSTD
+    if (zstd_) {
+        ZSTD_inBuffer in{nullptr, 0, 0};
+        size_t remaining;
+        do {
+            ZSTD_outBuffer out{zstd_buf_.data(), zstd_buf_.size(), 0};
+            remaining = ZSTD_compressStream2(static_cast<ZSTD_CCtx*>(zstd_),
+                                             &out, &in, ZSTD_e_end);
+            if (ZSTD_isError(remaining) ||
+                fwrite(zstd_buf_.data(), 1, out.pos, out_) != out.pos) {
+                failed_ = true;
+                return false;
+            }
+        } while (remaining != 0);
+    }
+#endif
+
+    if (fflush(out_) != 0) failed_ = true;
+    return !failed_;
+}
+
+bool ArchiveWriter::close(string* error) {
+    lock_guard<mutex> lock(m_);
+    if (!out_) return true;
+
+    bool ok = finish_locked();
+    if (owns_out_ && fclose(out_) != 0) ok = false;
+    out_ = nullptr;
+
+#ifdef REDWARP_WITH_ZSTD
+    ZSTD_freeCCtx(static_cast<ZSTD_CCtx*>(zstd_));
+    zstd_ = nullptr;
+#endif
+
+    if (!ok && error) *error = "Write to archive failed.";
+    return ok;
+}
+
+} // namespace redwarp
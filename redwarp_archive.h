@@ -0,0 +1,64 @@
+#ifndef REDWARP_ARCHIVE_H
+#define REDWARP_ARCHIVE_H
+
+// ---------------------------------------------------------------------------
+// Streaming archive output – batch runs write every finished config straight
+// into one ustar archive (optionally zstd-compressed) or to stdout, instead
+// of one small file per profile.  An index.jsonl member with one JSON object
+// per profile is appended when the archive is closed.
+//
+// zstd support is compiled in with -DREDWARP_WITH_ZSTD (make ZSTD=1).
+// ---------------------------------------------------------------------------
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace redwarp {
+
+struct ArchiveEntry {
+    std::string name;       // profile name
+    std::string endpoint;   // endpoint picked for it
+};
+
+class ArchiveWriter {
+public:
+    ArchiveWriter() = default;
+    ~ArchiveWriter();
+
+    ArchiveWriter(const ArchiveWriter&)            = delete;
+    ArchiveWriter& operator=(const ArchiveWriter&) = delete;
+
+    // path "-" streams to stdout.  zstd_level > 0 compresses the stream.
+    bool open(const std::string& path, int zstd_level, std::string* error = nullptr);
+
+    // Append <entry.name>.conf; safe to call from several threads.
+    bool add(const ArchiveEntry& entry, const std::string& config,
+             std::string* error = nullptr);
+
+    // Append index.jsonl, the end-of-archive marker and flush everything.
+    bool close(std::string* error = nullptr);
+
+    static bool zstd_available();
+
+private:
+    bool add_member_locked(const std::string& name, const std::string& data);
+    bool write_locked(const void* data, size_t size);
+    bool finish_locked();
+
+    std::mutex         m_;
+    std::FILE*         out_       = nullptr;
+    bool               owns_out_  = false;
+    bool               failed_    = false;
+    std::string        index_;
+    std::vector<char>  file_buf_;
+    // Present in every build so the layout never depends on REDWARP_WITH_ZSTD
+    void*              zstd_      = nullptr;   // ZSTD_CCtx*
+    std::vector<char>  zstd_buf_;
+};
+
+} // namespace redwarp
+
+#endif // REDWARP_ARCHIVE_H
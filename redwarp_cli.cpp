@@ -0,0 +1,376 @@
+#include "redwarp.h"
+#include "redwarp_scheduler.h"
+#include "redwarp_daemon.h"
+#include "redwarp_archive.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <filesystem>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <set>
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// ---------------------------------------------------------------------------
+// Usage
+// ---------------------------------------------------------------------------
+static void usage() {
+    cerr <<
+        "Usage: redwarp-cli batch  --count N --out DIR [options]\n"
+        "       redwarp-cli daemon --socket PATH [options]\n"
+        "\n"
+        "Batch options:\n"
+        "  --count N          number of profiles to generate\n"
+        "  --out DIR          output directory (configs, accounts, job state)\n"
+        "  --prefix NAME      profile name prefix (default: profile)\n"
+        "  --state FILE       job state file (default: DIR/jobs.tsv)\n"
+        "  --rate R           registrations per second (default: 1)\n"
+        "  --burst B          token bucket size (default: 1)\n"
+        "  --jobs J           concurrent wgcf processes (default: 4)\n"
+        "  --attempts A       attempts per profile (default: 8)\n"
+        "  --backoff MS       base backoff delay in ms (default: 1000)\n"
+        "  --max-backoff MS   backoff ceiling in ms (default: 60000)\n"
+        "  --archive FILE     stream configs into one tar archive ('-' = stdout)\n"
+        "                     instead of DIR/<name>.conf, plus index.jsonl\n"
+        "  --zstd             compress the archive (implied by .zst / .tzst)\n"
+        "  --zstd-level N     zstd compression level (default: 3)\n"
+        "\n"
+        "Daemon options (--rate, --burst, --backoff, --max-backoff apply too):\n"
+        "  --socket PATH      Unix domain socket to listen on\n"
+        "  --pool N           profiles kept ready (default: 16)\n"
+        "  --workers W        concurrent refills (default: 2)\n"
+        "  --wait MS          how long GET waits on an empty pool (default: 0)\n"
+        "\n"
+        "Config options:\n"
+        "  --wgcf PATH        wgcf binary (default: ./bin/wgcf*, downloaded if missing)\n"
+        "  --endpoint POOL    endpoint or endpoint pool\n"
+        "  --balance S        round-robin | weighted | hash\n"
+        "  --mtu N\n"
+        "  --no-ipv6\n"
+        "  --no-amnezia\n"
+        "  --randomize        randomize AmneziaWG parameters\n"
+        "  --dns4 LIST        IPv4 DNS servers\n"
+        "  --dns6 LIST        IPv6 DNS servers\n";
+}
+
+// ---------------------------------------------------------------------------
+// Argument parsing – every option is either a flag or takes one value
+// ---------------------------------------------------------------------------
+struct Args {
+    map<string, string> values;
+    vector<string>      flags;
+    bool                ok = true;
+
+    bool has(const string& f) const {
+        for (const auto& x : flags) if (x == f) return true;
+        return false;
+    }
+    string get(const string& k, const string& def = "") const {
+        auto it = values.find(k);
+        return it == values.end() ? def : it->second;
+    }
+};
+
+static Args parse_args(int argc, char** argv, int first) {
+    static const vector<string> FLAGS = {"--no-ipv6", "--no-amnezia", "--randomize",
+                                         "--zstd"};
+    Args a;
+    for (int i = first; i < argc; ++i) {
+        string k = argv[i];
+        bool is_flag = false;
+        for (const auto& f : FLAGS) if (k == f) is_flag = true;
+        if (is_flag) {
+            a.flags.push_back(k);
+        } else if (k.rfind("--", 0) == 0 && i + 1 < argc) {
+            a.values[k] = argv[++i];
+        } else {
+            cerr << "Unknown or incomplete option: " << k << "\n";
+            a.ok = false;
+        }
+    }
+    return a;
+}
+
+static bool parse_options(const Args& a, redwarp::Options& o) {
+    if (a.values.count("--wgcf"))     o.wgcf_path = a.get("--wgcf");
+    if (a.values.count("--endpoint")) o.endpoint  = a.get("--endpoint");
+    if (a.values.count("--mtu"))      o.mtu       = a.get("--mtu");
+    if (a.values.count("--dns4"))     o.dns_ipv4  = a.get("--dns4");
+    if (a.values.count("--dns6"))     o.dns_ipv6  = a.get("--dns6");
+    o.ipv6              = !a.has("--no-ipv6");
+    o.amnezia           = !a.has("--no-amnezia");
+    o.randomize_amnezia = a.has("--randomize");
+
+    const string balance = a.get("--balance", "round-robin");
+    if      (balance == "round-robin") o.endpoint_strategy = redwarp::EndpointStrategy::RoundRobin;
+    else if (balance == "weighted")    o.endpoint_strategy = redwarp::EndpointStrategy::Weighted;
+    else if (balance == "hash")        o.endpoint_strategy = redwarp::EndpointStrategy::Hash;
+    else {
+        cerr << "Unknown --balance strategy: " << balance << "\n";
+        return false;
+    }
+
+    string error;
+    if (redwarp::pick_endpoint(o, &error).empty()) {
+        cerr << error << "\n";
+        return false;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// batch – register and generate N profiles through the scheduler
+// ---------------------------------------------------------------------------
+static int cmd_batch(const Args& a) {
+    const long count = atol(a.get("--count", "0").c_str());
+    const string out_dir = a.get("--out");
+    if (count <= 0 || out_dir.empty()) {
+        usage();
+        return 2;
+    }
+
+    redwarp::Options base;
+    if (!parse_options(a, base)) return 2;
+
+    string error;
+    const string wgcf = redwarp::resolve_wgcf(base, &error);
+    if (wgcf.empty()) {
+        cerr << error << "\n";
+        return 1;
+    }
+
+    const string prefix = a.get("--prefix", "profile");
+    const size_t width  = to_string(count).size();
+    vector<string>      names;
+    map<string, size_t> index;
+    for (long i = 1; i <= count; ++i) {
+        string num = to_string(i);
+        string name = prefix + "-" + string(width - num.size(), '0') + num;
+        index[name] = names.size();
+        names.push_back(name);
+    }
+
+    const fs::path accounts = fs::path(out_dir) / "accounts";
+    error_code ec;
+    fs::create_directories(accounts, ec);
+    if (ec) {
+        cerr << "Could not create " << accounts.string() << ": " << ec.message() << "\n";
+        return 1;
+    }
+
+    // Archive mode: configs never touch the filesystem as separate files
+    const string archive_path = a.get("--archive");
+    redwarp::ArchiveWriter archive;
+    if (!archive_path.empty()) {
+        auto ends_with = [&](const string& suffix) {
+            return archive_path.size() >= suffix.size() &&
+                   archive_path.compare(archive_path.size() - suffix.size(),
+                                        suffix.size(), suffix) == 0;
+        };
+        const bool zstd = a.has("--zstd") || ends_with(".zst") || ends_with(".tzst");
+        const int level = zstd ? max(1, atoi(a.get("--zstd-level", "3").c_str())) : 0;
+        if (!archive.open(archive_path, level, &error)) {
+            cerr << error << "\n";
+            return 1;
+        }
+    }
+
+    redwarp::SchedulerOptions sched;
+    sched.rate                 = atof(a.get("--rate", "1").c_str());
+    sched.burst                = atof(a.get("--burst", "1").c_str());
+    sched.concurrency          = unsigned(max(1, atoi(a.get("--jobs", "4").c_str())));
+    sched.backoff.max_attempts = atoi(a.get("--attempts", "8").c_str());
+    sched.backoff.base         = chrono::milliseconds(atol(a.get("--backoff", "1000").c_str()));
+    sched.backoff.max          = chrono::milliseconds(atol(a.get("--max-backoff", "60000").c_str()));
+    sched.state_file           = a.get("--state", (fs::path(out_dir) / "jobs.tsv").string());
+
+    // Generate a config from an existing account and store it.  A failed
+    // archive write poisons the archive, so it cancels the whole run instead
+    // of spending retries (and API calls) on every remaining profile.
+    mutex        archived_m;
+    set<string>  archived;
+    atomic<bool> archive_failed{false};
+    string       archive_error;
+    redwarp::RegistrationScheduler* active = nullptr;
+    auto emit = [&](const string& name) -> redwarp::RegisterOutcome {
+        redwarp::RegisterOutcome out;
+        if (archive_failed) {
+            out.error = "Archive write failed earlier.";
+            return out;
+        }
+
+        redwarp::Options o = base;
+        o.profile_name = name;
+        o.sequence     = index.at(name);
+
+        redwarp::Result res =
+            redwarp::generate_from_account(wgcf, (accounts / name).string(), o);
+        if (!res.ok) {
+            out.status = res.rate_limited ? redwarp::RegisterOutcome::RateLimited
+                                          : redwarp::RegisterOutcome::Failed;
+            out.error  = res.error;
+            return out;
+        }
+
+        if (!archive_path.empty()) {
+            if (!archive.add({name, res.endpoint}, res.config, &out.error)) {
+                if (!archive_failed.exchange(true)) {
+                    {
+                        lock_guard<mutex> lock(archived_m);
+                        archive_error = out.error;
+                    }
+                    active->cancel();
+                }
+                return out;
+            }
+            lock_guard<mutex> lock(archived_m);
+            archived.insert(name);
+        } else {
+            ofstream conf(fs::path(out_dir) / (name + ".conf"), ios::binary);
+            conf << res.config;
+            conf.close();
+            if (!conf) {
+                out.error = "Could not write " + name + ".conf";
+                return out;
+            }
+        }
+        out.status = redwarp::RegisterOutcome::Ok;
+        return out;
+    };
+
+    // One job = register (unless an earlier run already did) + generate
+    auto job = [&](const string& name) -> redwarp::RegisterOutcome {
+        const string account_dir = (accounts / name).string();
+        if (error_code ec; !fs::exists(fs::path(account_dir) / "wgcf-account.toml", ec)) {
+            redwarp::RegisterOutcome reg = redwarp::register_account(wgcf, account_dir);
+            if (reg.status != redwarp::RegisterOutcome::Ok) return reg;
+        }
+        return emit(name);
+    };
+
+    size_t finished = 0;
+    redwarp::RegistrationScheduler scheduler(sched, job);
+    active = &scheduler;
+    auto states = scheduler.run(names, [&](const redwarp::JobState& st) {
+        cerr << "[" << ++finished << "] " << st.name << " "
+             << (st.status == redwarp::JobState::Done ? "done" : "FAILED: " + st.error)
+             << " (" << st.attempts << " attempts)\n";
+    });
+
+    // A new archive must hold every profile, including those an earlier run
+    // finished: regenerate them from their saved accounts (no registration).
+    // wgcf generate is an API call too, so it gets the same pacing and retries.
+    size_t missing = 0;
+    vector<string> regenerate;
+    if (!archive_path.empty() && !archive_failed) {
+        for (const auto& st : states)
+            if (st.status == redwarp::JobState::Done && !archived.count(st.name))
+                regenerate.push_back(st.name);
+    }
+    if (!regenerate.empty()) {
+        cerr << "Regenerating " << regenerate.size()
+             << " profiles finished by an earlier run\n";
+        redwarp::SchedulerOptions again = sched;
+        again.state_file.clear();   // jobs.tsv already has them as done
+        redwarp::RegistrationScheduler regen(again, emit);
+        active = &regen;
+        regen.run(regenerate, [&](const redwarp::JobState& st) {
+            if (st.status == redwarp::JobState::Done) return;
+            cerr << st.name << " FAILED to regenerate: " << st.error
+                 << " (" << st.attempts << " attempts)\n";
+            ++missing;
+        });
+    }
+
+    if (archive_failed) {
+        cerr << archive_error << " Stopped; rerun to resume into a new archive.\n";
+        archive.close();
+        return 1;
+    }
+    if (!archive_path.empty() && !archive.close(&error)) {
+        cerr << error << "\n";
+        return 1;
+    }
+
+    size_t done = 0;
+    for (const auto& st : states)
+        if (st.status == redwarp::JobState::Done) ++done;
+    done -= missing;
+    cerr << done << "/" << states.size() << " profiles in "
+         << (archive_path.empty() ? out_dir : archive_path) << "\n";
+    return done == states.size() ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// daemon – serve pre-generated configs over a Unix socket until SIGINT/SIGTERM
+// ---------------------------------------------------------------------------
+static atomic<bool> g_stop{false};
+
+static void on_signal(int) { g_stop = true; }
+
+static int cmd_daemon(const Args& a) {
+    redwarp::DaemonOptions dopts;
+    dopts.socket_path = a.get("--socket");
+    dopts.wait        = chrono::milliseconds(atol(a.get("--wait", "0").c_str()));
+    if (dopts.socket_path.empty()) {
+        usage();
+        return 2;
+    }
+
+    redwarp::Options base;
+    if (!parse_options(a, base)) return 2;
+
+    // Resolve once: refills would otherwise rescan bin/ on every profile
+    string error;
+    base.wgcf_path = redwarp::resolve_wgcf(base, &error);
+    if (base.wgcf_path.empty()) {
+        cerr << error << "\n";
+        return 1;
+    }
+
+    redwarp::PoolOptions pool;
+    pool.target       = size_t(max(1L, atol(a.get("--pool", "16").c_str())));
+    pool.workers      = unsigned(max(1, atoi(a.get("--workers", "2").c_str())));
+    pool.rate         = atof(a.get("--rate", "1").c_str());
+    pool.burst        = atof(a.get("--burst", "1").c_str());
+    pool.backoff.base = chrono::milliseconds(atol(a.get("--backoff", "1000").c_str()));
+    pool.backoff.max  = chrono::milliseconds(atol(a.get("--max-backoff", "60000").c_str()));
+
+    signal(SIGINT,  on_signal);
+    signal(SIGTERM, on_signal);
+
+    redwarp::Daemon daemon(base, pool, dopts);
+    cerr << "Listening on " << dopts.socket_path << "\n";
+    if (!daemon.run(g_stop, &error)) {
+        cerr << error << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// main
+// ---------------------------------------------------------------------------
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+
+    const string cmd = argv[1];
+    Args args = parse_args(argc, argv, 2);
+    if (!args.ok) return 2;
+
+    if (cmd == "batch")  return cmd_batch(args);
+    if (cmd == "daemon") return cmd_daemon(args);
+
+    usage();
+    return 2;
+}
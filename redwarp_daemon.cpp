@@ -0,0 +1,439 @@
+#include "redwarp_daemon.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+#ifndef _WIN32
+#  include <cerrno>
+#  include <fcntl.h>
+#  include <poll.h>
+#  include <unistd.h>
+#  include <sys/socket.h>
+#  include <sys/stat.h>
+#  include <sys/un.h>
+#endif
+
+using namespace std;
+
+namespace redwarp {
+
+using steady = chrono::steady_clock;
+
+static double seconds_since(steady::time_point t0) {
+    return chrono::duration<double>(steady::now() - t0).count();
+}
+
+// ---------------------------------------------------------------------------
+// Histogram
+// ---------------------------------------------------------------------------
+Histogram::Histogram(vector<double> bounds)
+    : bounds_(std::move(bounds)), counts_(bounds_.size() + 1, 0) {}
+
+void Histogram::observe(double seconds) {
+    lock_guard<mutex> lock(m_);
+    size_t i = size_t(lower_bound(bounds_.begin(), bounds_.end(), seconds) -
+                      bounds_.begin());
+    ++counts_[i];
+    sum_ += seconds;
+    ++count_;
+}
+
+void Histogram::write(ostream& out, const string& name, const string& help) const {
+    lock_guard<mutex> lock(m_);
+    out << "# HELP " << name << " " << help << "\n"
+        << "# TYPE " << name << " histogram\n";
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < bounds_.size(); ++i) {
+        cumulative += counts_[i];
+        out << name << "_bucket{le=\"" << bounds_[i] << "\"} " << cumulative << "\n";
+    }
+    out << name << "_bucket{le=\"+Inf\"} " << count_ << "\n"
+        << name << "_sum " << sum_ << "\n"
+        << name << "_count " << count_ << "\n";
+}
+
+static void write_metric(ostream& out, const string& name, const char* type,
+                         const string& help, double value) {
+    out << "# HELP " << name << " " << help << "\n"
+        << "# TYPE " << name << " " << type << "\n"
+        << name << " " << value << "\n";
+}
+
+// ---------------------------------------------------------------------------
+// ProfilePool
+// ---------------------------------------------------------------------------
+ProfilePool::ProfilePool(Options base, PoolOptions opts)
+    : base_(std::move(base)),
+      opts_(std::move(opts)),
+      bucket_(opts_.rate, opts_.burst),
+      refill_latency_({0.5, 1, 2, 5, 10, 20, 30, 60}) {}
+
+ProfilePool::~ProfilePool() { stop(); }
+
+void ProfilePool::start() {
+    lock_guard<mutex> lock(m_);
+    if (!workers_.empty()) return;
+    stopping_ = false;
+    bucket_.resume();
+    for (unsigned i = 0; i < max(1u, opts_.workers); ++i)
+        workers_.emplace_back(&ProfilePool::refill_worker, this);
+}
+
+void ProfilePool::stop() {
+    vector<thread> workers;
+    {
+        lock_guard<mutex> lock(m_);
+        stopping_ = true;
+        workers.swap(workers_);
+    }
+    bucket_.cancel();
+    changed_.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+void ProfilePool::refill_worker() {
+    int failures = 0;
+    unique_lock<mutex> lock(m_);
+    for (;;) {
+        changed_.wait(lock, [&] {
+            return stopping_ || ready_.size() + in_flight_ < opts_.target;
+        });
+        if (stopping_) return;
+        ++in_flight_;
+        lock.unlock();
+
+        if (!bucket_.acquire()) {
+            lock.lock();
+            --in_flight_;
+            return;
+        }
+        const steady::time_point t0 = steady::now();
+        Result res;
+        try {
+            res = fetch_profile(base_);
+        } catch (const exception& e) {
+            res.error = e.what();
+        }
+
+        chrono::milliseconds delay{0};
+        if (res.ok) {
+            refill_latency_.observe(seconds_since(t0));
+            bucket_.reward();
+            failures = 0;
+        } else {
+            ++refill_failures_;
+            delay = opts_.backoff.delay(failures++);
+            if (res.rate_limited) {
+                ++refill_rate_limited_;
+                bucket_.penalize(max(delay, opts_.backoff.base));
+            }
+        }
+
+        lock.lock();
+        --in_flight_;
+        if (res.ok) ready_.push_back(std::move(res.config));
+        changed_.notify_all();
+        if (!res.ok)
+            changed_.wait_for(lock, delay, [&] { return stopping_; });
+    }
+}
+
+bool ProfilePool::take(string& profile, chrono::milliseconds wait) {
+    unique_lock<mutex> lock(m_);
+    changed_.wait_for(lock, wait, [&] { return stopping_ || !ready_.empty(); });
+    if (ready_.empty()) return false;
+    profile = std::move(ready_.front());
+    ready_.pop_front();
+    changed_.notify_all();   // wake a refill worker
+    return true;
+}
+
+size_t ProfilePool::size() const {
+    lock_guard<mutex> lock(m_);
+    return ready_.size();
+}
+
+void ProfilePool::write_metrics(ostream& out) const {
+    size_t ready, in_flight;
+    {
+        lock_guard<mutex> lock(m_);
+        ready     = ready_.size();
+        in_flight = in_flight_;
+    }
+    write_metric(out, "redwarp_pool_profiles", "gauge",
+                 "Profiles ready to hand out.", double(ready));
+    write_metric(out, "redwarp_pool_target", "gauge",
+                 "Profiles the pool tries to keep ready.", double(opts_.target));
+    write_metric(out, "redwarp_pool_refills_in_flight", "gauge",
+                 "Registrations currently running.", double(in_flight));
+    write_metric(out, "redwarp_pool_registration_rate", "gauge",
+                 "Current registration rate limit per second.", bucket_.rate());
+    write_metric(out, "redwarp_pool_refill_failures_total", "counter",
+                 "Failed refill attempts.", double(refill_failures_.load()));
+    write_metric(out, "redwarp_pool_refill_rate_limited_total", "counter",
+                 "Refill attempts rejected with HTTP 429.",
+                 double(refill_rate_limited_.load()));
+    refill_latency_.write(out, "redwarp_pool_refill_seconds",
+                          "Time to register and generate one profile.");
+}
+
+// ---------------------------------------------------------------------------
+// Daemon – request handling
+// ---------------------------------------------------------------------------
+Daemon::Daemon(Options base, PoolOptions pool, DaemonOptions opts)
+    : base_(std::move(base)),
+      opts_(std::move(opts)),
+      pool_(base_, std::move(pool)),
+      request_latency_({0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025,
+                        0.05, 0.1, 0.25, 0.5, 1}) {}
+
+static bool parse_bool(const string& v, bool& out) {
+    if (v == "1" || v == "yes" || v == "true")  { out = true;  return true; }
+    if (v == "0" || v == "no"  || v == "false") { out = false; return true; }
+    return false;
+}
+
+static bool apply_override(Options& o, const string& key, const string& value,
+                           string& error) {
+    bool ok = true;
+    if      (key == "dns4")      o.dns_ipv4     = value;
+    else if (key == "dns6")      o.dns_ipv6     = value;
+    else if (key == "mtu")       o.mtu          = value;
+    else if (key == "endpoint")  o.endpoint     = value;
+    else if (key == "name")      o.profile_name = value;
+    else if (key == "ipv6")      ok = parse_bool(value, o.ipv6);
+    else if (key == "amnezia")   ok = parse_bool(value, o.amnezia);
+    else if (key == "randomize") ok = parse_bool(value, o.randomize_amnezia);
+    else if (key == "balance") {
+        if      (value == "round-robin") o.endpoint_strategy = EndpointStrategy::RoundRobin;
+        else if (value == "weighted")    o.endpoint_strategy = EndpointStrategy::Weighted;
+        else if (value == "hash")        o.endpoint_strategy = EndpointStrategy::Hash;
+        else ok = false;
+    } else {
+        error = "unknown key " + key;
+        return false;
+    }
+    if (!ok) error = "bad value for " + key;
+    return ok;
+}
+
+static string reply_ok(const string& body) {
+    return "OK " + to_string(body.size()) + "\n" + body;
+}
+
+static string reply_err(string reason) {
+    replace(reason.begin(), reason.end(), '\n', ' ');
+    return "ERR " + reason + "\n";
+}
+
+string Daemon::metrics() const {
+    ostringstream out;
+    pool_.write_metrics(out);
+    out << "# HELP redwarp_requests_total GET requests by result.\n"
+        << "# TYPE redwarp_requests_total counter\n"
+        << "redwarp_requests_total{result=\"ok\"} "    << requests_ok_.load()    << "\n"
+        << "redwarp_requests_total{result=\"empty\"} " << requests_empty_.load() << "\n"
+        << "redwarp_requests_total{result=\"error\"} " << requests_error_.load() << "\n";
+    request_latency_.write(out, "redwarp_request_seconds",
+                           "Time to answer a GET request.");
+    return out.str();
+}
+
+string Daemon::handle(const string& request) {
+    const steady::time_point t0 = steady::now();
+
+    istringstream in(request);
+    string cmd;
+    in >> cmd;
+
+    if (cmd == "STATS") return reply_ok(metrics());
+    if (cmd != "GET")   return reply_err("unknown command " + cmd);
+
+    const uint64_t seq = sequence_++;
+    Options o = base_;
+    o.sequence     = seq;
+    o.profile_name = "profile-" + to_string(seq);
+
+    auto fail = [&](const string& reason) {
+        ++requests_error_;
+        request_latency_.observe(seconds_since(t0));
+        return reply_err(reason);
+    };
+
+    string token, error;
+    while (in >> token) {
+        size_t eq = token.find('=');
+        if (eq == string::npos) return fail("expected key=value, got " + token);
+        if (!apply_override(o, token.substr(0, eq), token.substr(eq + 1), error))
+            return fail(error);
+    }
+    // Reject a bad endpoint before a pooled profile is used up
+    if (pick_endpoint(o, &error).empty()) return fail(error);
+
+    string profile;
+    if (!pool_.take(profile, opts_.wait)) {
+        ++requests_empty_;
+        request_latency_.observe(seconds_since(t0));
+        return reply_err("pool empty");
+    }
+
+    Result res = finish_profile(profile, o);
+    if (!res.ok) return fail(res.error);
+
+    ++requests_ok_;
+    request_latency_.observe(seconds_since(t0));
+    return reply_ok(res.config);
+}
+
+// ---------------------------------------------------------------------------
+// Daemon – Unix domain socket server
+// ---------------------------------------------------------------------------
+#ifdef _WIN32
+
+bool Daemon::run(const atomic<bool>&, string* error) {
+    if (error) *error = "Daemon mode needs Unix domain sockets and is not available on Windows.";
+    return false;
+}
+
+void Daemon::serve_client(int) {}
+
+#else
+
+static bool write_all(int fd, const string& data) {
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;
+#endif
+    size_t off = 0;
+    while (off < data.size()) {
+        ssize_t n = send(fd, data.data() + off, data.size() - off, flags);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        off += size_t(n);
+    }
+    return true;
+}
+
+void Daemon::serve_client(int fd) {
+    static const size_t MAX_LINE = 4096;
+
+    string buf;
+    char chunk[1024];
+    bool open = true;
+    while (open) {
+        size_t nl;
+        while (open && (nl = buf.find('\n')) != string::npos) {
+            string line = buf.substr(0, nl);
+            buf.erase(0, nl + 1);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!line.empty()) open = write_all(fd, handle(line));
+        }
+        if (!open) break;
+        if (buf.size() > MAX_LINE) {
+            write_all(fd, reply_err("request too long"));
+            break;
+        }
+
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        buf.append(chunk, size_t(n));
+    }
+
+    lock_guard<mutex> lock(clients_m_);
+    clients_.erase(remove(clients_.begin(), clients_.end(), fd), clients_.end());
+    close(fd);
+    clients_done_.notify_all();
+}
+
+bool Daemon::run(const atomic<bool>& stop, string* error) {
+    auto fail = [&](const string& what) {
+        if (error) *error = what + ": " + strerror(errno);
+        return false;
+    };
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (opts_.socket_path.empty() ||
+        opts_.socket_path.size() >= sizeof(addr.sun_path)) {
+        if (error) *error = "Socket path is empty or too long.";
+        return false;
+    }
+    memcpy(addr.sun_path, opts_.socket_path.c_str(), opts_.socket_path.size() + 1);
+
+    // Replace a stale socket from an earlier run, but never a regular file
+    struct stat st{};
+    if (lstat(opts_.socket_path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+        unlink(opts_.socket_path.c_str());
+
+    // Close-on-exec from the start: refill workers fork wgcf concurrently
+#ifdef SOCK_CLOEXEC
+    int lfd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+#else
+    int lfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (lfd >= 0) fcntl(lfd, F_SETFD, FD_CLOEXEC);
+#endif
+    if (lfd < 0) return fail("socket");
+    // Configs carry private keys – owner only, from the moment the socket
+    // appears.  Refill workers are not running yet, so nothing else forks
+    // or creates files while the umask is narrowed.
+    const mode_t old_mask = umask(077);
+    const int bound = bind(lfd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    umask(old_mask);
+    if (bound != 0) {
+        close(lfd);
+        return fail("bind " + opts_.socket_path);
+    }
+    chmod(opts_.socket_path.c_str(), S_IRUSR | S_IWUSR);
+    if (listen(lfd, 64) != 0) {
+        close(lfd);
+        unlink(opts_.socket_path.c_str());
+        return fail("listen");
+    }
+
+    pool_.start();
+
+    while (!stop) {
+        pollfd pfd{lfd, POLLIN, 0};
+        int r = poll(&pfd, 1, 200);
+        if (r <= 0) continue;
+
+#ifdef __linux__
+        int cfd = accept4(lfd, nullptr, nullptr, SOCK_CLOEXEC);
+#else
+        int cfd = accept(lfd, nullptr, nullptr);
+        if (cfd >= 0) fcntl(cfd, F_SETFD, FD_CLOEXEC);
+#endif
+        if (cfd < 0) continue;
+#ifdef SO_NOSIGPIPE
+        int one = 1;
+        setsockopt(cfd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+        {
+            lock_guard<mutex> lock(clients_m_);
+            clients_.push_back(cfd);
+        }
+        thread(&Daemon::serve_client, this, cfd).detach();
+    }
+
+    close(lfd);
+    unlink(opts_.socket_path.c_str());
+
+    // Wake clients blocked in recv() and wait for their threads to finish
+    {
+        unique_lock<mutex> lock(clients_m_);
+        for (int fd : clients_) shutdown(fd, SHUT_RDWR);
+        clients_done_.wait(lock, [&] { return clients_.empty(); });
+    }
+
+    pool_.stop();
+    return true;
+}
+
+#endif
+
+} // namespace redwarp
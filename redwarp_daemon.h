@@ -0,0 +1,129 @@
+#ifndef REDWARP_DAEMON_H
+#define REDWARP_DAEMON_H
+
+// ---------------------------------------------------------------------------
+// Config daemon – keeps a pool of registered-but-unassigned profiles topped
+// up in the background and hands them out over a Unix domain socket.
+//
+// Protocol: one request per line, answers are length-prefixed.
+//   GET [key=value ...]   -> "OK <bytes>\n<config>"   or "ERR <reason>\n"
+//   STATS                 -> "OK <bytes>\n<metrics>"  (Prometheus text format)
+// GET keys override the daemon's options for that one config:
+//   dns4, dns6, mtu, ipv6, amnezia, randomize (0/1), endpoint, balance, name
+// Values cannot contain spaces: separate DNS servers with ',' and endpoint
+// pool entries with ';'.
+// ---------------------------------------------------------------------------
+
+#include "redwarp.h"
+#include "redwarp_scheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace redwarp {
+
+// Cumulative histogram in seconds, rendered in Prometheus text format
+class Histogram {
+public:
+    explicit Histogram(std::vector<double> bounds);
+
+    void observe(double seconds);
+    void write(std::ostream& out, const std::string& name,
+               const std::string& help) const;
+
+private:
+    mutable std::mutex    m_;
+    std::vector<double>   bounds_;
+    std::vector<uint64_t> counts_;   // one per bound, plus +Inf
+    double                sum_   = 0;
+    uint64_t              count_ = 0;
+};
+
+struct PoolOptions {
+    size_t        target  = 16;   // profiles kept ready
+    unsigned      workers = 2;    // concurrent refills
+    double        rate    = 1.0;  // registrations per second
+    double        burst   = 1.0;
+    BackoffPolicy backoff;
+};
+
+class ProfilePool {
+public:
+    ProfilePool(Options base, PoolOptions opts);
+    ~ProfilePool();
+
+    void start();
+    void stop();
+
+    // Pop a raw profile, waiting up to `wait` for a refill if the pool is empty.
+    bool take(std::string& profile, std::chrono::milliseconds wait);
+
+    size_t size() const;
+    void   write_metrics(std::ostream& out) const;
+
+private:
+    void refill_worker();
+
+    const Options      base_;
+    const PoolOptions  opts_;
+    TokenBucket        bucket_;
+
+    mutable std::mutex       m_;
+    std::condition_variable  changed_;
+    std::deque<std::string>  ready_;
+    size_t                   in_flight_ = 0;
+    bool                     stopping_  = false;
+    std::vector<std::thread> workers_;
+
+    Histogram              refill_latency_;
+    std::atomic<uint64_t>  refill_failures_{0};
+    std::atomic<uint64_t>  refill_rate_limited_{0};
+};
+
+struct DaemonOptions {
+    std::string               socket_path;
+    std::chrono::milliseconds wait{0};   // how long GET may wait on an empty pool
+};
+
+class Daemon {
+public:
+    Daemon(Options base, PoolOptions pool, DaemonOptions opts);
+
+    // Serve until `stop` becomes true.  Returns false and fills *error if
+    // the socket cannot be set up.
+    bool run(const std::atomic<bool>& stop, std::string* error = nullptr);
+
+    // Answer one request line; exposed so the protocol can be driven
+    // without a socket.
+    std::string handle(const std::string& request);
+
+private:
+    void serve_client(int fd);
+    std::string metrics() const;
+
+    const Options        base_;
+    const DaemonOptions  opts_;
+    ProfilePool          pool_;
+    std::atomic<uint64_t> sequence_{0};
+
+    Histogram              request_latency_;
+    std::atomic<uint64_t>  requests_ok_{0};
+    std::atomic<uint64_t>  requests_empty_{0};
+    std::atomic<uint64_t>  requests_error_{0};
+
+    std::mutex              clients_m_;
+    std::condition_variable clients_done_;
+    std::vector<int>        clients_;
+};
+
+} // namespace redwarp
+
+#endif // REDWARP_DAEMON_H
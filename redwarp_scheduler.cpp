@@ -0,0 +1,304 @@
+#include "redwarp_scheduler.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace redwarp {
+
+// ---------------------------------------------------------------------------
+// TokenBucket
+// ---------------------------------------------------------------------------
+TokenBucket::TokenBucket(double rate, double burst)
+    : max_rate_(rate > 0 ? rate : 1.0),
+      burst_(burst >= 1 ? burst : 1.0),
+      rate_(max_rate_),
+      tokens_(burst_),
+      last_(clock::now()),
+      paused_until_(last_) {}
+
+void TokenBucket::refill(clock::time_point now) {
+    // Nothing accrues while paused
+    clock::time_point from = max(last_, paused_until_);
+    if (now > from) {
+        chrono::duration<double> dt = now - from;
+        tokens_ = min(burst_, tokens_ + dt.count() * rate_);
+    }
+    last_ = max(last_, now);
+}
+
+bool TokenBucket::acquire() {
+    unique_lock<mutex> lock(m_);
+    for (;;) {
+        if (cancelled_) return false;
+
+        clock::duration wait;
+        const clock::time_point now = clock::now();
+        if (now < paused_until_) {
+            wait = paused_until_ - now;
+        } else {
+            refill(now);
+            if (tokens_ >= 1.0) {
+                tokens_ -= 1.0;
+                return true;
+            }
+            wait = chrono::duration_cast<clock::duration>(
+                chrono::duration<double>((1.0 - tokens_) / rate_));
+        }
+        cancelled_cv_.wait_for(lock, wait, [&] { return cancelled_; });
+    }
+}
+
+void TokenBucket::cancel() {
+    {
+        lock_guard<mutex> lock(m_);
+        cancelled_ = true;
+    }
+    cancelled_cv_.notify_all();
+}
+
+void TokenBucket::resume() {
+    lock_guard<mutex> lock(m_);
+    cancelled_ = false;
+}
+
+void TokenBucket::penalize(chrono::milliseconds pause) {
+    lock_guard<mutex> lock(m_);
+    const clock::time_point now = clock::now();
+    refill(now);
+    rate_         = max(rate_ / 2, max_rate_ / 64);
+    tokens_       = 0;
+    paused_until_ = max(paused_until_, now + pause);
+}
+
+void TokenBucket::reward() {
+    lock_guard<mutex> lock(m_);
+    rate_ = min(max_rate_, rate_ + max_rate_ / 16);
+}
+
+double TokenBucket::rate() const {
+    lock_guard<mutex> lock(m_);
+    return rate_;
+}
+
+// ---------------------------------------------------------------------------
+// BackoffPolicy
+// ---------------------------------------------------------------------------
+chrono::milliseconds BackoffPolicy::delay(int attempt) const {
+    thread_local mt19937_64 gen{random_device{}()};
+    const int shift = std::min(std::max(attempt, 0), 30);
+    const long long cap = min<long long>(max.count(),
+                                         base.count() * (1LL << shift));
+    uniform_int_distribution<long long> d(0, cap > 0 ? cap : 0);
+    return chrono::milliseconds(d(gen));
+}
+
+// ---------------------------------------------------------------------------
+// Job state file – one tab-separated line per job:
+//   name <TAB> pending|done|failed <TAB> attempts <TAB> last error
+// While running, every state change is appended as another line (the last
+// line for a name wins); run() rewrites it to one line per job at the end.
+// ---------------------------------------------------------------------------
+static const char* status_name(JobState::Status s) {
+    switch (s) {
+    case JobState::Done:   return "done";
+    case JobState::Failed: return "failed";
+    default:               return "pending";
+    }
+}
+
+static JobState::Status parse_status(const string& s) {
+    if (s == "done")   return JobState::Done;
+    if (s == "failed") return JobState::Failed;
+    return JobState::Pending;
+}
+
+// Errors go into a single TSV field
+static string one_line(string s) {
+    for (auto& c : s)
+        if (c == '\t' || c == '\r' || c == '\n') c = ' ';
+    return s;
+}
+
+RegistrationScheduler::RegistrationScheduler(SchedulerOptions opts, JobFn job)
+    : opts_(std::move(opts)),
+      job_(std::move(job)),
+      bucket_(opts_.rate, opts_.burst) {}
+
+void RegistrationScheduler::load_state() {
+    map<string, JobState> saved;
+    vector<string>        order;
+
+    if (!opts_.state_file.empty()) {
+        ifstream in(opts_.state_file);
+        string line;
+        while (getline(in, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            istringstream fields(line);
+            JobState st;
+            string status, attempts;
+            getline(fields, st.name, '\t');
+            getline(fields, status, '\t');
+            getline(fields, attempts, '\t');
+            getline(fields, st.error);
+            if (st.name.empty()) continue;
+            st.status   = parse_status(status);
+            st.attempts = atoi(attempts.c_str());
+            if (!saved.count(st.name)) order.push_back(st.name);
+            saved[st.name] = st;
+        }
+    }
+
+    for (auto& job : jobs_) {
+        auto it = saved.find(job.name);
+        if (it == saved.end()) continue;
+        job = it->second;
+        saved.erase(it);
+    }
+    for (const auto& name : order)
+        if (saved.count(name)) others_.push_back(saved[name]);
+}
+
+static void write_state_line(ostream& out, const JobState& j) {
+    out << j.name << '\t' << status_name(j.status) << '\t'
+        << j.attempts << '\t' << one_line(j.error) << '\n';
+}
+
+void RegistrationScheduler::compact_state_locked() {
+    if (opts_.state_file.empty()) return;
+
+    // Write-then-rename so a crash never leaves a truncated state file
+    const string tmp = opts_.state_file + ".tmp";
+    {
+        ofstream out(tmp, ios::trunc);
+        out << "# name\tstatus\tattempts\terror\n";
+        for (const auto* list : {&jobs_, &others_})
+            for (const auto& j : *list) write_state_line(out, j);
+        if (!out) return;
+    }
+    error_code ec;
+    fs::rename(tmp, opts_.state_file, ec);
+}
+
+void RegistrationScheduler::append_state_locked(const JobState& job) {
+    if (!journal_.is_open()) return;
+    write_state_line(journal_, job);
+    journal_.flush();
+}
+
+void RegistrationScheduler::worker() {
+    for (;;) {
+        size_t idx;
+        string name;
+        {
+            lock_guard<mutex> lock(m_);
+            if (cancelled_) return;
+            while (next_ < jobs_.size() && jobs_[next_].status == JobState::Done)
+                ++next_;
+            if (next_ >= jobs_.size()) return;
+            idx  = next_++;
+            name = jobs_[idx].name;
+        }
+
+        for (int attempt = 1;; ++attempt) {
+            // Cancelled: leave this job Pending for the next run
+            if (!bucket_.acquire()) return;
+
+            RegisterOutcome out;
+            try {
+                out = job_(name);
+            } catch (const exception& e) {
+                out.status = RegisterOutcome::Failed;
+                out.error  = e.what();
+            }
+
+            const bool last = attempt >= max(opts_.backoff.max_attempts, 1);
+            {
+                lock_guard<mutex> lock(m_);
+                JobState& job = jobs_[idx];
+                ++job.attempts;
+                if (out.status == RegisterOutcome::Ok) {
+                    job.status = JobState::Done;
+                    job.error.clear();
+                } else {
+                    job.status = last ? JobState::Failed : JobState::Pending;
+                    job.error  = one_line(out.error);
+                }
+                append_state_locked(job);
+                if (job.status != JobState::Pending && on_finish_)
+                    on_finish_(job);
+            }
+
+            if (out.status == RegisterOutcome::Ok) {
+                bucket_.reward();
+                break;
+            }
+            if (last) break;
+
+            // Full jitter can draw 0 ms; the shared pause gets at least base
+            const chrono::milliseconds d = opts_.backoff.delay(attempt - 1);
+            if (out.status == RegisterOutcome::RateLimited)
+                bucket_.penalize(max(d, opts_.backoff.base));
+            unique_lock<mutex> lock(m_);
+            if (cancelled_cv_.wait_for(lock, d, [&] { return cancelled_; }))
+                return;
+        }
+    }
+}
+
+void RegistrationScheduler::cancel() {
+    {
+        lock_guard<mutex> lock(m_);
+        cancelled_ = true;
+    }
+    cancelled_cv_.notify_all();
+    bucket_.cancel();
+}
+
+vector<JobState> RegistrationScheduler::run(const vector<string>& names,
+                                            const function<void(const JobState&)>& on_finish) {
+    {
+        lock_guard<mutex> lock(m_);
+        jobs_.clear();
+        others_.clear();
+        for (const auto& n : names) {
+            JobState st;
+            st.name = n;
+            jobs_.push_back(st);
+        }
+        load_state();
+        // Failed jobs from an earlier run get a fresh set of attempts
+        for (auto& j : jobs_)
+            if (j.status == JobState::Failed) j.status = JobState::Pending;
+        next_      = 0;
+        cancelled_ = false;
+        on_finish_ = on_finish;
+        bucket_.resume();
+        compact_state_locked();
+        if (!opts_.state_file.empty())
+            journal_.open(opts_.state_file, ios::app);
+    }
+
+    const unsigned n = max(1u, min<unsigned>(opts_.concurrency,
+                                             unsigned(max<size_t>(jobs_.size(), 1))));
+    vector<thread> workers;
+    for (unsigned i = 0; i < n; ++i)
+        workers.emplace_back(&RegistrationScheduler::worker, this);
+    for (auto& t : workers) t.join();
+
+    lock_guard<mutex> lock(m_);
+    on_finish_ = nullptr;
+    journal_.close();
+    compact_state_locked();
+    return jobs_;
+}
+
+} // namespace redwarp
@@ -0,0 +1,128 @@
+#ifndef REDWARP_SCHEDULER_H
+#define REDWARP_SCHEDULER_H
+
+// ---------------------------------------------------------------------------
+// Registration scheduler – paces bulk account registration so large batches
+// finish at the highest rate the API tolerates instead of dying on HTTP 429.
+//
+//   TokenBucket          – shared request budget; halves its rate on 429,
+//                          creeps back up to the configured rate on success
+//   BackoffPolicy        – jittered exponential delay between attempts
+//   RegistrationScheduler– bounded worker pool + resumable on-disk job state
+// ---------------------------------------------------------------------------
+
+#include "redwarp.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace redwarp {
+
+class TokenBucket {
+public:
+    using clock = std::chrono::steady_clock;
+
+    // rate: tokens per second, burst: bucket capacity (>= 1)
+    TokenBucket(double rate, double burst);
+
+    // Block until a token is available, then take it.  Returns false without
+    // taking one once cancel() has been called.
+    bool acquire();
+    // Wake every waiting acquire() and make further calls fail until resume().
+    void cancel();
+    void resume();
+
+    // The server pushed back: hold every caller for `pause` and halve the rate.
+    void penalize(std::chrono::milliseconds pause);
+    // A request went through: grow the rate back towards the configured one.
+    void reward();
+
+    double rate() const;
+
+private:
+    void refill(clock::time_point now);
+
+    mutable std::mutex      m_;
+    std::condition_variable cancelled_cv_;
+    bool                    cancelled_ = false;
+    const double            max_rate_;
+    const double            burst_;
+    double                  rate_;
+    double                  tokens_;
+    clock::time_point       last_;
+    clock::time_point       paused_until_;
+};
+
+struct BackoffPolicy {
+    std::chrono::milliseconds base{1000};
+    std::chrono::milliseconds max{60000};
+    int                       max_attempts = 8;
+
+    // "Full jitter": uniform in [0, min(max, base * 2^attempt)]
+    std::chrono::milliseconds delay(int attempt) const;
+};
+
+struct JobState {
+    enum Status { Pending, Done, Failed };
+    std::string name;
+    Status      status   = Pending;
+    int         attempts = 0;
+    std::string error;      // last error, single line
+};
+
+// One unit of work; RateLimited results slow the whole scheduler down.
+using JobFn = std::function<RegisterOutcome(const std::string& name)>;
+
+struct SchedulerOptions {
+    double        rate        = 1.0;  // requests per second
+    double        burst       = 1.0;
+    unsigned      concurrency = 4;
+    BackoffPolicy backoff;
+    std::string   state_file;         // "" = keep state in memory only
+};
+
+class RegistrationScheduler {
+public:
+    RegistrationScheduler(SchedulerOptions opts, JobFn job);
+
+    // Run every name that is not already Done in state_file and return the
+    // final state of all of them.  Jobs that exhaust their attempts end up
+    // Failed and are retried on the next run.  on_finish is called once per
+    // job (Done or Failed), serialized across workers.
+    std::vector<JobState> run(const std::vector<std::string>& names,
+                              const std::function<void(const JobState&)>& on_finish = {});
+
+    // Stop the current run(): no new attempts start, waits are cut short and
+    // unfinished jobs stay Pending.  Safe to call from a job, but not from
+    // on_finish.
+    void cancel();
+
+private:
+    void load_state();
+    void compact_state_locked();
+    void append_state_locked(const JobState& job);
+    void worker();
+
+    SchedulerOptions      opts_;
+    JobFn                 job_;
+    TokenBucket           bucket_;
+
+    std::mutex            m_;
+    std::vector<JobState> jobs_;
+    std::vector<JobState> others_;   // state_file entries not in this run
+    size_t                next_ = 0;
+    bool                  cancelled_ = false;
+    std::condition_variable cancelled_cv_;
+    std::ofstream         journal_;  // state_file opened for appending
+    std::function<void(const JobState&)> on_finish_;
+};
+
+} // namespace redwarp
+
+#endif // REDWARP_SCHEDULER_H
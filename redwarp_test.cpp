@@ -0,0 +1,434 @@
+// ---------------------------------------------------------------------------
+// Library tests – run with `make test`.  Endpoint pool parsing and picking,
+// the scheduler driven by a fake job that answers 429 for a fixed number of
+// attempts per profile, and the real register/generate path against a stub
+// wgcf script that does the same.
+// ---------------------------------------------------------------------------
+#include "redwarp_scheduler.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                        \
+    do {                                                                   \
+        if (!(cond)) {                                                     \
+            cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: "      \
+                 << #cond << "\n";                                         \
+            ++failures;                                                    \
+        }                                                                  \
+    } while (0)
+
+// Fake registration: `limited[name]` 429s before the first success,
+// names in `broken` never succeed.
+struct FakeApi {
+    mutex              m;
+    map<string, int>   limited;
+    vector<string>     broken;
+    map<string, int>   calls;
+
+    redwarp::RegisterOutcome operator()(const string& name) {
+        lock_guard<mutex> lock(m);
+        redwarp::RegisterOutcome out;
+        const int n = calls[name]++;
+        for (const auto& b : broken) {
+            if (b == name) {
+                out.status = redwarp::RegisterOutcome::RateLimited;
+                out.error  = "Error: 429 Too Many Requests";
+                return out;
+            }
+        }
+        if (n < limited[name]) {
+            out.status = redwarp::RegisterOutcome::RateLimited;
+            out.error  = "Error: 429 Too Many Requests";
+            return out;
+        }
+        out.status = redwarp::RegisterOutcome::Ok;
+        return out;
+    }
+};
+
+static map<string, string> read_state(const string& path) {
+    map<string, string> status;
+    ifstream in(path);
+    string line;
+    while (getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        const size_t a = line.find('\t');
+        const size_t b = line.find('\t', a + 1);
+        status[line.substr(0, a)] = line.substr(a + 1, b - a - 1);
+    }
+    return status;
+}
+
+static string pick(const string& pool, redwarp::EndpointStrategy strategy,
+                   uint64_t sequence = 0, const string& name = "RedWARP") {
+    redwarp::Options o;
+    o.endpoint          = pool;
+    o.endpoint_strategy = strategy;
+    o.sequence          = sequence;
+    o.profile_name      = name;
+    return redwarp::pick_endpoint(o);
+}
+
+static string pick_rr(const string& pool, uint64_t sequence) {
+    return pick(pool, redwarp::EndpointStrategy::RoundRobin, sequence);
+}
+
+static void test_endpoint_pool() {
+    // Entries alternate; within an entry ports change fastest, then hosts
+    const string hosts = "1.1.1.1:1,2 2.2.2.2:3";
+    CHECK(pick_rr(hosts, 0) == "1.1.1.1:1");
+    CHECK(pick_rr(hosts, 1) == "2.2.2.2:3");
+    CHECK(pick_rr(hosts, 2) == "1.1.1.1:2");
+    CHECK(pick_rr(hosts, 3) == "2.2.2.2:3");
+    CHECK(pick_rr(hosts, 4) == "1.1.1.1:1");
+
+    // /30 skips the network and broadcast addresses
+    const string cidr = "10.0.0.0/30:7,8";
+    CHECK(pick_rr(cidr, 0) == "10.0.0.1:7");
+    CHECK(pick_rr(cidr, 1) == "10.0.0.1:8");
+    CHECK(pick_rr(cidr, 2) == "10.0.0.2:7");
+    CHECK(pick_rr(cidr, 3) == "10.0.0.2:8");
+    CHECK(pick_rr(cidr, 4) == "10.0.0.1:7");
+
+    // /31 and /32 use every address; the default port is 2408
+    CHECK(pick_rr("10.0.0.4/31", 0) == "10.0.0.4:2408");
+    CHECK(pick_rr("10.0.0.4/31", 1) == "10.0.0.5:2408");
+    CHECK(pick_rr("10.0.0.5/31", 2) == "10.0.0.4:2408");
+    CHECK(pick_rr("10.0.0.9/32:1", 0) == "10.0.0.9:1");
+    CHECK(pick_rr("10.0.0.9/32:1", 7) == "10.0.0.9:1");
+
+    // Separators, port ranges and IPv6 literals
+    CHECK(pick_rr("1.1.1.1:5-6;[2606:4700::1]:9", 1) == "[2606:4700::1]:9");
+    CHECK(pick_rr("1.1.1.1:5-6;[2606:4700::1]:9", 2) == "1.1.1.1:6");
+
+    const vector<string> invalid = {
+        "",                     // empty pool
+        "1.1.1.1:0",            // port 0
+        "1.1.1.1:70000",        // port out of range
+        "1.1.1.1:9-3",          // reversed range
+        "1.1.1.1:80,x",         // not a number
+        "1.1.1.1:80@0",         // zero weight
+        "1.1.1.1:80@x",         // bad weight
+        "1.1.1.1:80@2000000",   // weight too large
+        "10.0.0.0/33",          // prefix too long
+        "10.0.0/24",            // short address
+        "256.0.0.0/8",          // octet out of range
+        "10.0.0.0/",            // missing prefix length
+        "[2606:4700::1",        // unterminated IPv6
+        ":2408",                // missing host
+    };
+    for (const auto& spec : invalid) {
+        redwarp::Options o;
+        o.endpoint = spec;
+        string error;
+        const string picked = redwarp::pick_endpoint(o, &error);
+        if (!picked.empty() || error.empty())
+            cerr << "accepted invalid pool \"" << spec << "\"\n";
+        CHECK(picked.empty());
+        CHECK(!error.empty());
+    }
+
+    // Hash: the same name always lands on the same endpoint, names spread
+    // across entries, and removing an entry only moves the names it had
+    const string four   = "10.0.1.0/24:1 10.0.2.0/24:2 10.0.3.0/24:3 10.0.4.0/24:4";
+    const string three  = "10.0.1.0/24:1 10.0.2.0/24:2 10.0.3.0/24:3";
+    const auto hash     = redwarp::EndpointStrategy::Hash;
+    map<string, int> per_port;
+    for (int i = 0; i < 200; ++i) {
+        const string name = "profile-" + to_string(i);
+        const string a = pick(four, hash, 0, name);
+        CHECK(a == pick(four, hash, 99, name));
+        ++per_port[a.substr(a.rfind(':'))];
+        if (a.substr(a.rfind(':')) != ":4")
+            CHECK(pick(three, hash, 0, name) == a);
+    }
+    CHECK(per_port.size() == 4);
+}
+
+static void test_token_bucket() {
+    redwarp::TokenBucket bucket(8.0, 1.0);
+    CHECK(bucket.rate() == 8.0);
+
+    bucket.penalize(chrono::milliseconds(1));
+    CHECK(bucket.rate() == 4.0);
+    bucket.penalize(chrono::milliseconds(1));
+    CHECK(bucket.rate() == 2.0);
+
+    // Never drops below max/64
+    for (int i = 0; i < 20; ++i) bucket.penalize(chrono::milliseconds(0));
+    CHECK(bucket.rate() == 8.0 / 64);
+
+    bucket.reward();
+    CHECK(bucket.rate() > 8.0 / 64);
+    for (int i = 0; i < 20; ++i) bucket.reward();
+    CHECK(bucket.rate() == 8.0);
+
+    // The pause holds acquire() back even with a full bucket
+    redwarp::TokenBucket paused(1000.0, 10.0);
+    paused.penalize(chrono::milliseconds(50));
+    const auto t0 = chrono::steady_clock::now();
+    paused.acquire();
+    CHECK(chrono::steady_clock::now() - t0 >= chrono::milliseconds(45));
+
+    // cancel() wakes a caller stuck behind a long pause
+    redwarp::TokenBucket stuck(1.0, 1.0);
+    stuck.penalize(chrono::milliseconds(60000));
+    bool got = true;
+    thread waiter([&] { got = stuck.acquire(); });
+    this_thread::sleep_for(chrono::milliseconds(20));
+    stuck.cancel();
+    waiter.join();
+    CHECK(!got);
+    CHECK(!stuck.acquire());
+}
+
+static void test_scheduler_retries_and_resume() {
+    const fs::path dir = fs::temp_directory_path() / "redwarp-test-scheduler";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const string state = (dir / "jobs.tsv").string();
+
+    const vector<string> names = {"p-1", "p-2", "p-3", "p-4", "p-5"};
+
+    redwarp::SchedulerOptions opts;
+    opts.rate                 = 1000;
+    opts.burst                = 5;
+    opts.concurrency          = 3;
+    opts.backoff.base         = chrono::milliseconds(1);
+    opts.backoff.max          = chrono::milliseconds(4);
+    opts.backoff.max_attempts = 4;
+    opts.state_file           = state;
+
+    // First run: p-2 and p-4 recover after some 429s, p-5 never does
+    FakeApi api;
+    api.limited = {{"p-2", 2}, {"p-4", 3}};
+    api.broken  = {"p-5"};
+
+    size_t finished = 0;
+    redwarp::RegistrationScheduler first(opts, [&](const string& n) { return api(n); });
+    auto states = first.run(names, [&](const redwarp::JobState&) { ++finished; });
+
+    CHECK(states.size() == names.size());
+    CHECK(finished == names.size());
+    for (const auto& st : states) {
+        if (st.name == "p-5") {
+            CHECK(st.status == redwarp::JobState::Failed);
+            CHECK(st.attempts == 4);
+        } else {
+            CHECK(st.status == redwarp::JobState::Done);
+        }
+        if (st.name == "p-2") CHECK(st.attempts == 3);
+        if (st.name == "p-4") CHECK(st.attempts == 4);
+    }
+
+    auto saved = read_state(state);
+    CHECK(saved.size() == names.size());
+    CHECK(saved["p-1"] == "done");
+    CHECK(saved["p-2"] == "done");
+    CHECK(saved["p-4"] == "done");
+    CHECK(saved["p-5"] == "failed");
+
+    // Second run: only the failed job is attempted again
+    FakeApi again;
+    redwarp::RegistrationScheduler second(opts, [&](const string& n) { return again(n); });
+    states = second.run(names);
+
+    CHECK(again.calls.size() == 1);
+    CHECK(again.calls.count("p-5") == 1);
+    for (const auto& st : states)
+        CHECK(st.status == redwarp::JobState::Done);
+    saved = read_state(state);
+    CHECK(saved["p-5"] == "done");
+
+    fs::remove_all(dir);
+}
+
+static void test_scheduler_cancel() {
+    const fs::path dir = fs::temp_directory_path() / "redwarp-test-cancel";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    vector<string> names;
+    for (int i = 1; i <= 10; ++i) names.push_back("c-" + to_string(i));
+
+    redwarp::SchedulerOptions opts;
+    opts.rate                 = 1000;
+    opts.burst                = 10;
+    opts.concurrency          = 1;
+    opts.backoff.base         = chrono::milliseconds(60000);
+    opts.backoff.max          = chrono::milliseconds(60000);
+    opts.backoff.max_attempts = 8;
+    opts.state_file           = (dir / "jobs.tsv").string();
+
+    // The third job fails fatally and cancels the run from inside the job;
+    // the long backoff must not delay the return
+    int calls = 0;
+    redwarp::RegistrationScheduler* self = nullptr;
+    redwarp::RegistrationScheduler scheduler(opts, [&](const string&) {
+        redwarp::RegisterOutcome out;
+        if (++calls == 3) {
+            self->cancel();
+            out.error = "archive write failed";
+            return out;
+        }
+        out.status = redwarp::RegisterOutcome::Ok;
+        return out;
+    });
+    self = &scheduler;
+
+    const auto t0 = chrono::steady_clock::now();
+    auto states = scheduler.run(names);
+    CHECK(chrono::steady_clock::now() - t0 < chrono::seconds(5));
+
+    CHECK(calls == 3);
+    size_t done = 0, pending = 0;
+    for (const auto& st : states) {
+        if (st.status == redwarp::JobState::Done)    ++done;
+        if (st.status == redwarp::JobState::Pending) ++pending;
+    }
+    CHECK(done == 2);
+    CHECK(pending == 8);
+    auto saved = read_state(opts.state_file);
+    CHECK(saved["c-3"] == "pending");
+    CHECK(saved["c-10"] == "pending");
+
+    fs::remove_all(dir);
+}
+
+#ifndef _WIN32
+// Stub wgcf: every command counts its calls in the account dir it runs in
+// and answers `output` with a non-zero exit for the first N of them.
+static string write_stub_wgcf(const fs::path& dir, int register_fails,
+                              int generate_fails,
+                              const string& output = "Error: 429 Too Many Requests") {
+    const fs::path path = dir / "wgcf-stub";
+    ofstream out(path);
+    out << "#!/bin/sh\n"
+           "f=\".calls-$1\"\n"
+           "n=$(cat \"$f\" 2>/dev/null || echo 0)\n"
+           "n=$((n + 1))\n"
+           "echo $n > \"$f\"\n"
+           "case \"$1\" in\n"
+           "register)\n"
+           "  if [ $n -le " << register_fails << " ]; then echo '" << output << "'; exit 1; fi\n"
+           "  echo 'access_token = \"stub\"' > wgcf-account.toml ;;\n"
+           "generate)\n"
+           "  if [ $n -le " << generate_fails << " ]; then echo '" << output << "'; exit 1; fi\n"
+           "  cat > wgcf-profile.conf <<EOF\n"
+           "[Interface]\n"
+           "PrivateKey = stub=\n"
+           "Address = 172.16.0.2/32, 2606:4700:110:8a36::1/128\n"
+           "DNS = 1.1.1.1\n"
+           "MTU = 1280\n"
+           "[Peer]\n"
+           "PublicKey = stub=\n"
+           "AllowedIPs = 0.0.0.0/0, ::/0\n"
+           "Endpoint = engage.cloudflareclient.com:2408\n"
+           "EOF\n"
+           "  ;;\n"
+           "esac\n";
+    out.close();
+    fs::permissions(path, fs::perms::owner_all);
+    return path.string();
+}
+
+static void test_stub_wgcf() {
+    const fs::path dir = fs::temp_directory_path() / "redwarp-test-wgcf";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    // wgcf's own output decides between RateLimited and Failed
+    {
+        const string wgcf = write_stub_wgcf(dir, 1, 0);
+        redwarp::RegisterOutcome out = redwarp::register_account(wgcf, (dir / "a").string());
+        CHECK(out.status == redwarp::RegisterOutcome::RateLimited);
+        out = redwarp::register_account(wgcf, (dir / "a").string());
+        CHECK(out.status == redwarp::RegisterOutcome::Ok);
+    }
+    int account_no = 0;
+    auto classify = [&](const string& text) {
+        const string wgcf = write_stub_wgcf(dir, 1, 0, text);
+        const fs::path account = dir / ("classify-" + to_string(++account_no));
+        return redwarp::register_account(wgcf, account.string()).status;
+    };
+    for (const string text : {"HTTP 429", "unexpected status code: 429",
+                              "(429) slow down", "rate limit exceeded"})
+        CHECK(classify(text) == redwarp::RegisterOutcome::RateLimited);
+    // "429" inside an ID or a longer number is not a status code
+    for (const string text : {"device 7f429c0e not found", "error 4290",
+                              "request id a429: unauthorized"})
+        CHECK(classify(text) == redwarp::RegisterOutcome::Failed);
+
+    // The batch path: register (unless done) + generate, paced and retried
+    // by the scheduler.  Two 429s on register, one on generate.
+    const string wgcf = write_stub_wgcf(dir, 2, 1);
+    const fs::path accounts = dir / "accounts";
+
+    redwarp::SchedulerOptions opts;
+    opts.rate                 = 1000;
+    opts.burst                = 4;
+    opts.concurrency          = 2;
+    opts.backoff.base         = chrono::milliseconds(1);
+    opts.backoff.max          = chrono::milliseconds(4);
+    opts.backoff.max_attempts = 6;
+    opts.state_file           = (dir / "jobs.tsv").string();
+
+    auto job = [&](const string& name) -> redwarp::RegisterOutcome {
+        const string account_dir = (accounts / name).string();
+        if (!fs::exists(fs::path(account_dir) / "wgcf-account.toml")) {
+            redwarp::RegisterOutcome reg = redwarp::register_account(wgcf, account_dir);
+            if (reg.status != redwarp::RegisterOutcome::Ok) return reg;
+        }
+        redwarp::Options o;
+        o.profile_name = name;
+        redwarp::Result res = redwarp::generate_from_account(wgcf, account_dir, o);
+        redwarp::RegisterOutcome out;
+        if (res.ok) out.status = redwarp::RegisterOutcome::Ok;
+        else if (res.rate_limited) out.status = redwarp::RegisterOutcome::RateLimited;
+        out.error = res.error;
+        return out;
+    };
+
+    const vector<string> names = {"s-1", "s-2", "s-3"};
+    redwarp::RegistrationScheduler scheduler(opts, job);
+    auto states = scheduler.run(names);
+    for (const auto& st : states) {
+        CHECK(st.status == redwarp::JobState::Done);
+        CHECK(st.attempts == 4);
+    }
+    auto saved = read_state(opts.state_file);
+    for (const auto& n : names) CHECK(saved[n] == "done");
+
+    fs::remove_all(dir);
+}
+#endif
+
+int main() {
+    test_endpoint_pool();
+    test_token_bucket();
+    test_scheduler_retries_and_resume();
+    test_scheduler_cancel();
+#ifndef _WIN32
+    test_stub_wgcf();
+#endif
+
+    if (failures) {
+        cerr << failures << " check(s) failed\n";
+        return 1;
+    }
+    cerr << "All tests passed\n";
+    return 0;
+}